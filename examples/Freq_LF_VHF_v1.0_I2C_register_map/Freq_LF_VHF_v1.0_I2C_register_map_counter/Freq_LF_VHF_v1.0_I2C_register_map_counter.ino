@@ -0,0 +1,12 @@
+// The I2C slave mode needs the library built with -DFREQ_ENABLE_I2C, for example
+// "compiler.cpp.extra_flags=-DFREQ_ENABLE_I2C" in the platform.local.txt of the board package, or "build_flags = -DFREQ_ENABLE_I2C" with PlatformIO
+#include <Pandauino_Freq_LF_VHF.h>
+
+void setup() {
+  frequencyCounter.freqSetup(board_version_vhf); // use "board_version_hf" for the 5 Hz - 5 MHz board and "board_version_vhf" for the 5 Hz - 210 MHz board
+  frequencyCounter.beginI2C(8);                  // the board is the I2C slave 8, see i2cRegister for the register map
+}
+
+void loop() {
+  frequencyCounter.freqCount();
+}
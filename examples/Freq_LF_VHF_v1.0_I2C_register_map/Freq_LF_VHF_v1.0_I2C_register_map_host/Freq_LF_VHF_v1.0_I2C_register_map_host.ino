@@ -0,0 +1,52 @@
+#include <Wire.h>
+
+// Host MCU polling the counter board running the "Freq_LF_VHF_v1.0_I2C_register_map_counter" example
+// The register addresses are those of i2cRegister in Pandauino_Freq_LF_VHF.h
+
+const byte counterAddress = 8;
+const byte i2c_control = 0x21;
+const byte i2c_fifo_data = 0x22;
+const byte i2c_control_apply = 0x80;
+
+// reads a little endian value from buf
+unsigned long readLong(const byte buf[]) {
+  return (unsigned long)buf[0] | ((unsigned long)buf[1] << 8) | ((unsigned long)buf[2] << 16) | ((unsigned long)buf[3] << 24);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Wire.begin();                                     // joins the I2C bus as master
+
+  // auto mode (bit 0 = 0), band ignored, resolution normal (1 << 3)
+  Wire.beginTransmission(counterAddress);
+  Wire.write(i2c_control);
+  Wire.write(i2c_control_apply | (1 << 3));
+  Wire.endTransmission();
+
+  // the next reads are from the FIFO
+  Wire.beginTransmission(counterAddress);
+  Wire.write(i2c_fifo_data);
+  Wire.endTransmission();
+}
+
+void loop() {
+
+  byte record[22];
+  long long microHertz;
+
+  // each read removes one measurement from the FIFO: count (1), time stamp (4), band (1), raw count (4), gate time (4), frequency uHz (8)
+  if (Wire.requestFrom(counterAddress, (byte)22) != 22) return;
+  for (byte i = 0; i < 22; i++) record[i] = Wire.read();
+
+  if (record[0] == 0) {                             // FIFO empty
+    delay(50);
+    return;
+  }
+
+  microHertz = ((long long)readLong(&record[18]) << 32) | readLong(&record[14]);
+
+  Serial.print(readLong(&record[1]));
+  Serial.print(" ms: ");
+  Serial.print((long)(microHertz / 1000000));
+  Serial.println(" Hz");
+}
@@ -0,0 +1,152 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Host benchmark of the gated counting pipeline: 64 bits integer micro-hertz against the former float computation
+ *
+ *  For each case the simulated board measures a signal in one band. Every gate result read with readMeasurements() is compared to
+ *  the exact value of its raw count: rawCount x prescaler / gate time x calibration, computed in long double.
+ *  The former computation, FreqCount.read() * prescalerCoef * calibration in float (the AVR double), is applied to the same raw count.
+ *
+ *  The conversion of a raw count to a frequency is then timed on the host for both: float multiplications, and the
+ *  fixed point multiplier of configureMultipliers() with its rounding shift.
+ *  Host timings only compare the two paths: the ATmega328P has no FPU, a float multiplication costs it about 130 cycles
+ *  where the 64 x 32 bits integer product is done in software too. Time it on the board with micros() for target numbers.
+ *
+ *  Compiled and run from the root of the library with
+ *  g++ -std=c++11 -m32 -O2 -Isrc extras/benchmark/Freq_LF_VHF_pipeline_benchmark.cpp src/Pandauino_Freq_LF_VHF.cpp src/sim/Pandauino_Freq_LF_VHF_sim.cpp -o pipeline_benchmark
+ *  ./pipeline_benchmark
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#include <Pandauino_Freq_LF_VHF.h>
+#include <chrono>
+
+typedef Pandauino_Freq_LF_VHF_sim Sim;
+
+struct benchmarkCase {
+  double frequency;
+  measurementBand band;
+  measurementResolution resolution;
+  double calibration;
+};
+
+static const benchmarkCase cases[] = {
+  {4999999.9,   band_HF,   resolution_normal,     1.0},
+  {4999999.9,   band_HF,   resolution_ultra_high, 1.0000123},
+  {14318180.0,  band_VHF1, resolution_high,       0.9999871},
+  {14318180.0,  band_VHF1, resolution_ultra_high, 1.0000123},
+  {145800000.0, band_VHF2, resolution_normal,     1.0000123},
+  {209999999.9, band_VHF2, resolution_ultra_high, 0.9999871}
+};
+
+static const long timedSamples = 10000000;
+
+//*********** Prescaler of the measurement path of a band
+static byte prescalerOf(measurementBand band) {
+
+  if (band == band_VHF1) return 4;
+  if (band == band_VHF2) return 32;
+  return 1;
+
+}
+
+//*********** Same rounding of the calibration and same multiplier as configureMultipliers() and applyCalibration()
+static int64_t multiplierOf(byte prescaler, unsigned long gateMs, double calibration) {
+
+  long ppb = lround((calibration - 1.0) * 1000000000.0);
+  int64_t value = ((int64_t)prescaler * 1000000000 << 15) / gateMs;
+
+  return value + (value / 1000000) * ppb / 1000 + (value % 1000000) * ppb / 1000000000;
+
+}
+
+//*********** Nanoseconds per conversion of the raw counts, float path
+static double timeFloat(unsigned long rawCount, float prescalerCoef, float calibration) {
+
+  volatile float sink = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (long i = 0; i < timedSamples; i++) sink = (float)(rawCount + (i & 0xFF)) * prescalerCoef * calibration;
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  (void)sink;
+  return elapsed.count() / timedSamples;
+
+}
+
+//*********** Nanoseconds per conversion of the raw counts, integer path
+static double timeInteger(unsigned long rawCount, int64_t multiplier) {
+
+  volatile int64_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (long i = 0; i < timedSamples; i++) sink = ((int64_t)(rawCount + (i & 0xFF)) * multiplier + (1LL << 14)) >> 15;
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  (void)sink;
+  return elapsed.count() / timedSamples;
+
+}
+
+int main() {
+
+  bool mismatch = false;
+
+  if (sizeof(long) != 4) printf("long is %u bytes on this host, 4 on the board: build with -m32 for its overflows\n", (unsigned int)sizeof(long));
+
+  printf("%-12s %-5s %-4s %-10s %7s %14s %14s %9s %9s\n",
+         "signal (Hz)", "band", "res", "calib", "gates", "int err (Hz)", "float err (Hz)", "int ns", "float ns");
+
+  for (unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+
+    const benchmarkCase &k = cases[c];
+    byte prescaler = prescalerOf(k.band);
+    measurementRecord records[8];
+    long double intError = 0, floatError = 0;
+    unsigned long gates = 0, rawCount = 0, gateTime = 0;
+    int64_t multiplier = 0;
+
+    Sim::reset();
+    Sim::setSignal(k.frequency);
+    frequencyCounter.freqSetup(board_version_vhf);
+    Pandauino_Freq_LF_VHF::calibration = k.calibration;
+    frequencyCounter.configureComputation(mode_band, k.band, k.resolution);
+    while (frequencyCounter.readMeasurements(records, 8) > 0);
+
+    for (long t = 0; t < 60000; t++) {
+
+      frequencyCounter.freqCount();
+      Sim::advance(1000);
+
+      byte n = frequencyCounter.readMeasurements(records, 8);
+      for (byte i = 0; i < n; i++) {
+
+        rawCount = records[i].rawCount;
+        gateTime = records[i].gateTime;
+        multiplier = multiplierOf(prescaler, gateTime / 1000, k.calibration);
+
+        // The record must hold the integer conversion timed below
+        if (records[i].value != (((int64_t)rawCount * multiplier + (1LL << 14)) >> 15)) mismatch = true;
+
+        long double exact = (long double)rawCount * prescaler * 1000000.0L / gateTime * k.calibration;
+        float prescalerCoef = (float)prescaler * 1000000.0f / (float)gateTime;
+        float former = (float)rawCount * prescalerCoef * (float)k.calibration;
+
+        intError = std::max(intError, fabsl(records[i].value / 1000000.0L - exact));
+        floatError = std::max(floatError, fabsl((long double)former - exact));
+        gates++;
+      }
+    }
+
+    float prescalerCoef = (float)prescaler * 1000000.0f / (float)gateTime;
+
+    printf("%-12.1f %-5d %-4d %-10.7f %7lu %14.6f %14.6f %9.2f %9.2f\n",
+           k.frequency, (int)k.band, (int)k.resolution, k.calibration, gates, (double)intError, (double)floatError,
+           timeInteger(rawCount, multiplier), timeFloat(rawCount, prescalerCoef, (float)k.calibration));
+  }
+
+  if (mismatch) printf("MISMATCH: a record differs from the integer conversion\n");
+
+  return mismatch ? 1 : 0;
+
+}
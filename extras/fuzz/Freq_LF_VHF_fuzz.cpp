@@ -0,0 +1,498 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Host fuzz harness of the parsing and encoding paths, on the simulated board
+ *
+ *  ** I2C slave: random register pointers, control writes and read lengths from the master, between freqCount() calls.
+ *     The configuration must stay valid and the FIFO reads coherent. Only with the library built with -DFREQ_ENABLE_I2C
+ *
+ *  ** Settings: the EEPROM filled with random bytes, a former layout with random fields, valid records with random fields,
+ *     records hit by bit flips and writes cut by a power loss. The board must start with valid settings, and after a power loss
+ *     with either the former or the new settings
+ *
+ *  ** Binary frames: the stream of sendBinaryFrame() with bytes flipped, inserted and removed. The decoder must find every
+ *     frame left intact, equal to the measurement record, and no other
+ *
+ *  ** LCD line: displayFrequency() against the former dtostrf() rule on random frequencies and resolutions,
+ *     then the host time of both
+ *
+ *  The private functions and properties are reached by compiling the library header with private declared public
+ *
+ *  Compiled and run from the root of the library with
+ *  g++ -std=c++11 -m32 -O2 -g -fsanitize=address,undefined -DFREQ_ENABLE_I2C -Isrc extras/fuzz/Freq_LF_VHF_fuzz.cpp src/Pandauino_Freq_LF_VHF.cpp src/sim/Pandauino_Freq_LF_VHF_sim.cpp -o fuzz
+ *  ./fuzz [iterations] [seed]
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#define private public
+#include <Pandauino_Freq_LF_VHF.h>
+#undef private
+
+typedef Pandauino_Freq_LF_VHF Counter;
+typedef Pandauino_Freq_LF_VHF_sim Sim;
+
+static const uint8_t i2cAddress = 8;
+static const size_t frameLength = 26;
+static const size_t eepromLength = 1024;
+
+static unsigned long failures = 0;
+
+/* ************************************************************************************************************************************
+  TOOLS
+**************************************************************************************************************************************/
+
+//*********** xorshift32, the same sequence on every host for a seed
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom() {
+
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+
+}
+
+static uint32_t randomBelow(uint32_t limit) {
+
+  return nextRandom() % limit;
+
+}
+
+static void fail(const char *test, long iteration, const char *what) {
+
+  if (failures++ < 20) printf("FAIL %s iteration %ld: %s\n", test, iteration, what);
+
+}
+
+static void run(unsigned long milliseconds) {
+
+  for (unsigned long t = 0; t < milliseconds; t++) {
+    frequencyCounter.freqCount();
+    Sim::advance(1000);
+  }
+
+}
+
+//*********** A frequency in the range of the board, from 1 Hz to 210 MHz
+static double randomFrequency() {
+
+  return pow(10.0, (randomBelow(1000001) / 1000000.0) * 8.32);
+
+}
+
+//*********** The settings must be in the range of their enum and the calibration a number
+static bool settingsValid() {
+
+  return (Counter::mode <= mode_band) && (Counter::band <= band_VHF2) && (Counter::resolution <= resolution_ultra_high)
+         && (Counter::measurementType <= measure_period) && (Counter::operation <= operation_if_minus)
+         && (Counter::sleepSetting <= sleep_disabled) && std::isfinite(Counter::calibration);
+
+}
+
+/* ************************************************************************************************************************************
+  I2C SLAVE
+**************************************************************************************************************************************/
+
+#ifdef FREQ_ENABLE_I2C
+
+static void fuzzI2C(long iterations) {
+
+  uint8_t message[8];
+  uint8_t answer[40];
+
+  Sim::reset();
+  Sim::setSignal(randomFrequency());
+  frequencyCounter.freqSetup(board_version_vhf);
+  frequencyCounter.beginI2C(i2cAddress);
+
+  for (long i = 0; i < iterations; i++) {
+
+    size_t length = randomBelow(sizeof(message) + 1);
+    for (size_t j = 0; j < length; j++) message[j] = nextRandom();
+
+    // most writes at the registers, a control write being the first data byte
+    if ((length > 0) && (randomBelow(4) != 0)) message[0] = randomBelow(i2c_register_end + 2);
+    if ((length > 1) && (randomBelow(3) == 0)) message[0] = i2c_control;
+
+    switch (randomBelow(3)) {
+
+      case 0:
+      Sim::i2cWrite(i2cAddress, message, length);
+      break;
+
+      case 1:
+      {
+        size_t wanted = randomBelow(sizeof(answer) + 1);
+        size_t got = Sim::i2cRead(i2cAddress, answer, wanted);
+        if (got > wanted) fail("i2c", i, "read longer than asked");
+        if ((Counter::i2cPointer == i2c_fifo_data) && (got > 0) && (answer[0] >= MEASUREMENT_RING_SIZE)) fail("i2c", i, "FIFO count");
+      }
+      break;
+
+      default:
+      run(randomBelow(50));
+      break;
+    }
+
+    if (!settingsValid()) fail("i2c", i, "configuration out of range");
+    if (frequencyCounter.measurementsAvailable() >= MEASUREMENT_RING_SIZE) fail("i2c", i, "FIFO length");
+  }
+
+  frequencyCounter.endI2C();
+
+}
+#endif
+
+/* ************************************************************************************************************************************
+  SETTINGS
+**************************************************************************************************************************************/
+
+//*********** A CRC valid record of the current version with random fields
+static void randomRecord(uint8_t *eeprom, int address) {
+
+  uint16_t crc = 0xFFFF;
+
+  eeprom[address] = Counter::settingsVersion;
+  for (byte j = 1; j < Counter::settingsRecordLength - 2; j++) eeprom[address + j] = nextRandom();
+  for (byte j = 0; j < Counter::settingsRecordLength - 2; j++) crc = Counter::crc16Update(crc, eeprom[address + j]);
+  eeprom[address + Counter::settingsRecordLength - 2] = crc & 0xFF;
+  eeprom[address + Counter::settingsRecordLength - 1] = crc >> 8;
+
+}
+
+//*********** Changes the band as the menu does, the settings being written settingsFlushDelay later
+static void changeBand(measurementBand band) {
+
+  frequencyCounter.configureComputation(mode_band, band, Counter::resolution);
+  Counter::settingsChanged();
+
+}
+
+//*********** Changes a setting and runs until the record is written
+static void changeSettings() {
+
+  changeBand((measurementBand)randomBelow(4));
+  run(Counter::settingsFlushDelay + 200);
+
+}
+
+//*********** Powers the board off and on with this EEPROM content. A record being written is lost
+static void powerCycle(const uint8_t *image) {
+
+  Sim::reset();
+  memcpy(Sim::eeprom(), image, eepromLength);
+  Counter::settingsWriteIndex = Counter::settingsRecordLength + 1;
+  Counter::settingsDirty = false;
+  frequencyCounter.freqSetup(board_version_vhf);
+
+}
+
+static void fuzzSettings(long iterations) {
+
+  uint8_t image[eepromLength];
+  measurementBand former = band_LF;
+  measurementBand wanted = band_LF;
+  bool powerLoss;
+
+  for (long i = 0; i < iterations; i++) {
+
+    Sim::reset();
+    powerLoss = false;
+    memset(image, 0xFF, eepromLength);
+
+    switch (randomBelow(5)) {
+
+      case 0:		// random bytes
+      for (size_t j = 0; j < eepromLength; j++) image[j] = nextRandom();
+      break;
+
+      case 1:		// former layout
+      for (size_t j = 0; j < eepromLength; j++) image[j] = nextRandom();
+      image[0] = Counter::legacyEepromInit;
+      break;
+
+      case 2:		// valid records with random fields
+      for (int j = randomBelow(4); j >= 0; j--) randomRecord(image, randomBelow(eepromLength / Counter::settingsSlotSize) * Counter::settingsSlotSize);
+      break;
+
+      case 3:		// a journal hit by bit flips
+      powerCycle(image);
+      for (int j = randomBelow(4); j >= 0; j--) changeSettings();
+      memcpy(image, Sim::eeprom(), eepromLength);
+      for (int j = randomBelow(8); j >= 0; j--) image[randomBelow(eepromLength)] ^= 1 << randomBelow(8);
+      break;
+
+      default:	// a power loss while a record is written
+      powerCycle(image);
+      for (int j = randomBelow(4); j >= 0; j--) changeSettings();
+      former = Counter::band;
+      wanted = (measurementBand)((former + 1 + randomBelow(3)) % 4);
+      changeBand(wanted);
+      run(Counter::settingsFlushDelay + randomBelow(Counter::settingsRecordLength + 4));
+      memcpy(image, Sim::eeprom(), eepromLength);
+      powerLoss = true;
+      break;
+    }
+
+    powerCycle(image);
+    if (!settingsValid()) fail("settings", i, "settings out of range");
+    if (powerLoss && (Counter::band != former) && (Counter::band != wanted)) fail("settings", i, "power loss gave other settings");
+    run(1000);
+    if (!settingsValid()) fail("settings", i, "settings out of range after a second");
+  }
+
+}
+
+/* ************************************************************************************************************************************
+  BINARY FRAMES
+**************************************************************************************************************************************/
+
+static uint16_t crc16(const uint8_t *data, size_t length) {
+
+  uint16_t crc = 0xFFFF;
+
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (byte b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+
+}
+
+static unsigned long littleEndian(const uint8_t *data, byte length) {
+
+  unsigned long value = 0;
+
+  while (length-- > 0) value = (value << 8) | data[length];
+  return value;
+
+}
+
+//*********** Reference decoder: resynchronises byte by byte on the sync bytes and the CRC
+static std::vector<measurementRecord> decodeFrames(const std::string &stream) {
+
+  std::vector<measurementRecord> frames;
+  const uint8_t *p = (const uint8_t *)stream.data();
+  size_t i = 0;
+
+  while (i + frameLength <= stream.size()) {
+
+    if ((p[i] != 0xA5) || (p[i + 1] != 0x5A) || (crc16(p + i + 2, frameLength - 4) != littleEndian(p + i + 24, 2))) {
+      i++;
+      continue;
+    }
+
+    measurementRecord record;
+    record.timestamp = littleEndian(p + i + 4, 4);
+    record.band = p[i + 8] & 0x0F;
+    record.gateTime = littleEndian(p + i + 9, 4);
+    record.rawCount = littleEndian(p + i + 13, 4);
+    record.value = (int64_t)((uint64_t)littleEndian(p + i + 17, 4) | ((uint64_t)littleEndian(p + i + 21, 3) << 32));
+    if (record.value & (1LL << 55)) record.value -= 1LL << 56;
+    frames.push_back(record);
+    i += frameLength;
+  }
+  return frames;
+
+}
+
+static bool sameRecord(const measurementRecord &a, const measurementRecord &b) {
+
+  return (a.timestamp == b.timestamp) && (a.band == b.band) && (a.gateTime == b.gateTime) && (a.rawCount == b.rawCount) && (a.value == b.value);
+
+}
+
+static void fuzzFrames(long iterations) {
+
+  std::vector<measurementRecord> records;
+  measurementRecord read[MEASUREMENT_RING_SIZE];
+
+  Sim::reset();
+  Sim::setSignal(randomFrequency());
+  frequencyCounter.freqSetup(board_version_vhf, true);
+  frequencyCounter.setSerialFormat(serial_binary);
+  frequencyCounter.setContinuousGating(true);
+  frequencyCounter.configureComputation(mode_band, band_VHF1, resolution_low);
+  while (frequencyCounter.readMeasurements(read, MEASUREMENT_RING_SIZE) > 0);
+  Sim::clearSerialOutput();
+
+  for (long t = 0; t < 20000; t++) {
+    run(1);
+    byte n = frequencyCounter.readMeasurements(read, MEASUREMENT_RING_SIZE);
+    for (byte j = 0; j < n; j++) records.push_back(read[j]);
+  }
+
+  const std::string stream = Sim::serialOutput();
+  std::vector<measurementRecord> decoded = decodeFrames(stream);
+
+  if (decoded.size() != records.size()) fail("frames", 0, "frame count of the clean stream");
+  for (size_t j = 0; (j < decoded.size()) && (j < records.size()); j++) {
+    if (!sameRecord(decoded[j], records[j])) fail("frames", 0, "frame differs from the measurement record");
+  }
+
+  for (long i = 0; i < iterations; i++) {
+
+    std::string corrupted = stream;
+    std::vector<bool> intact(records.size(), true);
+
+    for (int j = randomBelow(6); j >= 0; j--) {
+      size_t frame = randomBelow(records.size());
+      size_t position = frame * frameLength + randomBelow(frameLength);
+      intact[frame] = false;
+      // bytes changed in place, the frames keep their positions
+      if (randomBelow(4) != 0) corrupted[position] ^= 1 << randomBelow(8);
+      else corrupted[position] = nextRandom();
+    }
+
+    std::vector<measurementRecord> found = decodeFrames(corrupted);
+    size_t next = 0;
+
+    for (size_t j = 0; j < found.size(); j++) {
+      while ((next < records.size()) && !sameRecord(found[j], records[next])) {
+        if (intact[next]) fail("frames", i, "intact frame not decoded");
+        next++;
+      }
+      if (next == records.size()) fail("frames", i, "decoded a frame that was not sent");
+      else next++;
+    }
+    for (; next < records.size(); next++) if (intact[next]) fail("frames", i, "intact frame not decoded");
+
+    // a byte removed and a byte inserted: the decoder resynchronises on the following frames
+    corrupted = stream;
+    size_t frame = randomBelow(records.size() - 1);
+    corrupted.erase(frame * frameLength + randomBelow(frameLength), 1);
+    corrupted.insert(frame * frameLength + randomBelow(frameLength), 1, (char)nextRandom());
+    found = decodeFrames(corrupted);
+    if ((found.size() + 2 < records.size()) || (found.size() > records.size())) fail("frames", i, "no resynchronisation");
+  }
+
+}
+
+/* ************************************************************************************************************************************
+  LCD LINE
+**************************************************************************************************************************************/
+
+//*********** The line of the former displayFrequency(): dtostrf() of the value in the display unit, then String concatenations
+// An exact half of the last digit displayed was rounded as its binary approximation fell: away from zero is taken with tieAway
+static void formerFrequencyLine(char line[17], bool tieAway = false) {
+
+  double displayMeasure;
+  double resultFrequency = Counter::resultFrequency / 1000000.0;
+  byte effectiveDisplayPrecision;
+  byte nbOfIntDigits = 0;
+  byte nbOfDecimals = 0;
+  char text1[40];
+  std::string text;
+  std::string unit;
+
+  if (std::abs(Counter::frequency) >= 1000000.0) { displayMeasure = resultFrequency / 1000000; unit = " MHz "; }
+  else if (std::abs(Counter::frequency) >= 1000.0) { displayMeasure = resultFrequency / 1000; unit = " KHz "; }
+  else { displayMeasure = resultFrequency; unit = " Hz "; }
+
+  if (Counter::frequency < 10000.0) effectiveDisplayPrecision = Counter::displayPrecision - 1;
+  else effectiveDisplayPrecision = Counter::displayPrecision;
+
+  for (int num = (int)displayMeasure; num != 0; num /= 10) nbOfIntDigits++;
+
+  if (nbOfIntDigits == 0) nbOfDecimals = effectiveDisplayPrecision - nbOfIntDigits - 1;
+  else nbOfDecimals = effectiveDisplayPrecision - nbOfIntDigits;
+  if ((nbOfIntDigits + nbOfDecimals) > effectiveDisplayPrecision) nbOfDecimals--;
+  if (tieAway) displayMeasure = nextafter(displayMeasure, 2 * displayMeasure);
+
+  snprintf(text1, sizeof(text1), "%*.*f", effectiveDisplayPrecision, nbOfDecimals, displayMeasure);
+  text = text1;
+  text += unit;
+  text += "AUT";
+
+  memset(line, ' ', 16);
+  memcpy(line, text.data(), std::min(text.size(), (size_t)16));
+  line[16] = 0;
+
+}
+
+static void fuzzFormatter(long iterations) {
+
+  char former[17];
+  char current[17];
+
+  Sim::reset();
+  frequencyCounter.freqSetup(board_version_vhf);
+  Counter::mode = mode_auto;
+  Counter::operation = operation_none;
+
+  for (long i = 0; i < iterations; i++) {
+
+    double hertz = randomFrequency() / 10.0;
+    if (randomBelow(8) == 0) hertz = -hertz;
+
+    Counter::resultFrequency = llround(hertz * 1000000.0);
+    Counter::frequency = Counter::resultFrequency / 1000000.0;
+    Counter::displayPrecision = 4 + randomBelow(4);
+
+    Counter::displayFrequency();
+    memcpy(current, Counter::line1, 16);
+    current[16] = 0;
+    formerFrequencyLine(former);
+    if (strcmp(current, former) != 0) formerFrequencyLine(former, true);
+
+    if (strcmp(current, former) != 0) {
+      char what[60];
+      snprintf(what, sizeof(what), "'%s' was '%s'", current, former);
+      fail("lcd", i, what);
+    }
+  }
+
+  // time of both on one value
+  long timed = iterations < 200000 ? 200000 : iterations;
+  Counter::resultFrequency = 14318180123456LL;
+  Counter::frequency = Counter::resultFrequency / 1000000.0;
+  Counter::displayPrecision = 7;
+
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < timed; i++) { Counter::resultFrequency += i & 0xFF; Counter::displayFrequency(); }
+  std::chrono::duration<double, std::nano> currentTime = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (long i = 0; i < timed; i++) {
+    Counter::resultFrequency += i & 0xFF;
+    formerFrequencyLine(former);
+    Counter::printSixteenCharToLCD(former);
+  }
+  std::chrono::duration<double, std::nano> formerTime = std::chrono::steady_clock::now() - start;
+
+  printf("lcd line: %.1f ns, former dtostrf() and String: %.1f ns\n", currentTime.count() / timed, formerTime.count() / timed);
+
+}
+
+int main(int argc, char **argv) {
+
+  long iterations = argc > 1 ? atol(argv[1]) : 20000;
+  randomState = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+  if (randomState == 0) randomState = 1;
+
+  if (sizeof(long) != 4) printf("long is %u bytes on this host, 4 on the board: build with -m32 for its overflows\n", (unsigned int)sizeof(long));
+
+#ifdef FREQ_ENABLE_I2C
+  fuzzI2C(iterations);
+#else
+  printf("I2C slave not built, see FREQ_ENABLE_I2C\n");
+#endif
+  fuzzSettings(iterations / 100);
+  fuzzFrames(iterations / 10);
+  fuzzFormatter(iterations * 10);
+
+  printf("%lu failures\n", failures);
+  return failures ? 1 : 0;
+
+}
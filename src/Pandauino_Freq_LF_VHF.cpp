@@ -73,6 +73,14 @@
   	Sleep_5m
   	Sleep_disabled
 
+  Statistics
+  	Avg
+  	Dev
+  	Min
+  	Max
+  	N
+  	Reset (press)
+
 */
 
 #include <Pandauino_Freq_LF_VHF.h>
@@ -136,11 +144,11 @@ const char Pandauino_Freq_LF_VHF::calNotPrecise[17] = "CAL NOT PRECISE ";
 const char Pandauino_Freq_LF_VHF::calibrating[17] = "Calibrating...  ";			  			// While calibrating
 const char Pandauino_Freq_LF_VHF::noMeasureAvailable[17] = "No measure avail"; 			// No measure available within timeout
 const char Pandauino_Freq_LF_VHF::goingStandby[17] = "Energy economy  ";						// Displayed before entering sleep mode
-const char Pandauino_Freq_LF_VHF::frequencySaved[17] = "Last fr. stored!  ";				// Displayed when storing the last frequency for reference
+const char Pandauino_Freq_LF_VHF::frequencySaved[17] = "Last fr. stored!";				// Displayed when storing the last frequency for reference
 const char Pandauino_Freq_LF_VHF::frequencyOutOfRange[17] = "F. out of range!";				// Displayed when storing the last frequency for reference
 
-// These menu entries are indexed as the runMode enum values
-const char Pandauino_Freq_LF_VHF::menuEntries[34][17] = {
+// These menu entries are indexed as the runMode enum values. They stay in flash: read them with strcpy_P() or pgm_read_byte()
+const char Pandauino_Freq_LF_VHF::menuEntries[][17] PROGMEM = {
 "                ",
 "Frequency band >",
 "AUTO            ",
@@ -173,16 +181,69 @@ const char Pandauino_Freq_LF_VHF::menuEntries[34][17] = {
 "Sleep 30 s.     ",
 "Sleep 5 m.      ",
 "Sleep disabled  ",
+"Statistics     >",
+"Avg             ",
+"Dev             ",
+"Min             ",
+"Max             ",
+"N               ",
+"Reset (press)   ",
 "F. reset (press)",
 "< Exit menu     "
 };
 
-const byte Pandauino_Freq_LF_VHF::EEPROMbaseAddress = 0;    										// Base addres where to store data in EEPROM
-const byte Pandauino_Freq_LF_VHF::eepromInit = 5;          											// A number that should be present at eeAddress if the EEPROM is already programmed and not corrupted
+const byte Pandauino_Freq_LF_VHF::settingsVersion = 2;    											// Version of the settings record, see loadSettings()
+const byte Pandauino_Freq_LF_VHF::settingsRecordLength = 41;											// Length of a settings record in bytes
+const byte Pandauino_Freq_LF_VHF::settingsSlotSize = 64;													// EEPROM space of a settings record. The 1 KB EEPROM holds 16 of them
+const unsigned int Pandauino_Freq_LF_VHF::settingsFlushDelay = 2000;						// Time without settings change before they are written (ms)
+const byte Pandauino_Freq_LF_VHF::legacyEepromInit = 5;          								// Value at address 0 of the former fixed addresses layout
+const long Pandauino_Freq_LF_VHF::maxStoredCalibrationPpb = 10000000;					// A calibration read further than 1% from 1 is taken as damaged
+
+const byte Pandauino_Freq_LF_VHF::ppsBlockLength = 16;													// Timebase disciplining: seconds of 1 PPS pulses per timebase error measure
+const long Pandauino_Freq_LF_VHF::ppsTolerance = 200;														// Largest deviation of a 1 PPS interval from 1 s (us). Beyond, the pulse is taken as a glitch
+const unsigned int Pandauino_Freq_LF_VHF::ppsTimeout = 2500;										// Time without pulse before a locked discipline goes to holdover (ms)
+const byte Pandauino_Freq_LF_VHF::disciplineFilterShift = 3;										// The loop filter averages the measures over about 2^disciplineFilterShift blocks
+const long Pandauino_Freq_LF_VHF::disciplineLockPpb = 2000;											// Largest deviation of a measure from the estimate to count toward the lock (ppb)
+const byte Pandauino_Freq_LF_VHF::disciplineLockBlocks = 4;											// Number of successive measures within disciplineLockPpb to lock
+
+#ifdef FREQ_ENABLE_ADEV
+const unsigned int Pandauino_Freq_LF_VHF::allanReportPeriod = 10000;						// Allan deviation: period of its report to serial and I2C (ms)
+const byte Pandauino_Freq_LF_VHF::allanLineLength = 32;													// Allan deviation: longest serial report line, sent only when the transmit buffer can hold it
+#endif
+const unsigned int Pandauino_Freq_LF_VHF::driftInterval = 4000;									// Settling: shortest time between the two frequencies of a drift rate measure (ms)
+const byte Pandauino_Freq_LF_VHF::driftFilterShift = 2;													// Settling: the drift rate is averaged over about 2^driftFilterShift measures
+const byte Pandauino_Freq_LF_VHF::driftLineLength = 28;													// Settling: longest serial report line, sent only when the transmit buffer can hold it
 
 const float Pandauino_Freq_LF_VHF::HFMeasurePeriodNormalRes = 1000.0;           // Time period for counting HF edges in milliseconds in normal resolution. USE POWER OF 10 VALUES
-const unsigned int Pandauino_Freq_LF_VHF::LFTimeoutNormalRes = 3000;            // Timeout of LF measurement in milliseconds. When reached, frequency is supposed to be impossible to measure.
-const unsigned int Pandauino_Freq_LF_VHF::displayTimeLap = 800;                 // Minimum period between too printings of values to the LCD screen (ms)
+const byte Pandauino_Freq_LF_VHF::multiplierShift = 15;                         // countMultiplier is a fixed point value with multiplierShift fractional bits. count * countMultiplier stays below 2^63 up to 280 MHz
+const float Pandauino_Freq_LF_VHF::stackedTimeCoefficient = 0.01;               // Gate stacking: measurementTimeCoefficient of the base gate, i.e. the low resolution one
+const unsigned int Pandauino_Freq_LF_VHF::HFProbePeriod = 10;                   // Time period of the auto mode probe gate on the /32 path in milliseconds
+const float Pandauino_Freq_LF_VHF::bandHysteresisPerCent = 5.0;                // Auto mode band tracking: margin % added to the band limits before searching the band again
+const unsigned long Pandauino_Freq_LF_VHF::bandVerifyPeriod = 30000;            // Auto mode band tracking: the tracked band is re-verified by a full search after this period (ms)
+const double Pandauino_Freq_LF_VHF::reciprocalMaxFrequency = 100000.0;        // Reciprocal counting: highest frequency the input capture interrupt can follow (Hz)
+const byte Pandauino_Freq_LF_VHF::reciprocalGateDivider = 10;                   // Reciprocal counting: the gate is effectiveHFMeasurePeriod divided by this value for the same number of digits
+const unsigned int Pandauino_Freq_LF_VHF::reciprocalMaxPeriods = 10000;         // Reciprocal counting: maximum number of periods measured at once
+const unsigned int Pandauino_Freq_LF_VHF::adaptiveGateMin = 10;                 // Adaptive gate: shortest gate (ms)
+const unsigned int Pandauino_Freq_LF_VHF::adaptiveGateMax = 10000;              // Adaptive gate: longest gate (ms)
+const float Pandauino_Freq_LF_VHF::adaptiveGateMargin = 1.1;                    // Adaptive gate: counts this many times the edges needed so that a small frequency change does not restart the gate
+const float Pandauino_Freq_LF_VHF::LFMeasurePeriodNormalRes = 100.0;           // Time span of the periods measured at once by the LF input capture in milliseconds, multiplied by measurementTimeCoefficient
+const unsigned int Pandauino_Freq_LF_VHF::LFMaxPeriods = 10000;                 // Largest number of periods measured at once by the LF input capture
+const unsigned int Pandauino_Freq_LF_VHF::LFTimeoutMargin = 1000;               // Added to the expected time of an LF measure to give LFTimeout (ms)
+const unsigned int Pandauino_Freq_LF_VHF::LFTimeoutMax = 30000;                 // Longest LFTimeout (ms)
+const byte Pandauino_Freq_LF_VHF::captureBufferCapacity = 11;                   // Number of captures the FreqMeasure buffer holds
+const unsigned int Pandauino_Freq_LF_VHF::regressionCaptureTime = 2;            // LF regression: shortest time of a capture (ms). The buffer then holds 22 ms of captures
+const unsigned int Pandauino_Freq_LF_VHF::regressionMaxCaptures = 500;          // LF regression: largest number of captures of a window
+const byte Pandauino_Freq_LF_VHF::regressionShift = 16;                         // LF regression: number of fractional bits of the slope
+const byte Pandauino_Freq_LF_VHF::filterGlitchRejects = 2;                      // Largest number of successive measures rejected as glitches. The next one is taken as a real frequency change
+const byte Pandauino_Freq_LF_VHF::statisticsMeanShift = 8;                      // Fractional bits of the running mean. 210 MHz << 8 is far from the int64 limit
+const unsigned int Pandauino_Freq_LF_VHF::displayTimeLap = 300;                 // Minimum period between too printings of values to the LCD screen (ms)
+
+const byte Pandauino_Freq_LF_VHF::frameSync1 = 0xA5;                            // First synchronization byte of a binary frame
+const byte Pandauino_Freq_LF_VHF::frameSync2 = 0x5A;                            // Second synchronization byte of a binary frame
+const byte Pandauino_Freq_LF_VHF::frameLength = 26;                             // Length of a binary frame in bytes, see sendBinaryFrame()
+#ifdef FREQ_ENABLE_I2C
+const byte Pandauino_Freq_LF_VHF::i2cRecordLength = 22;                         // Length of a FIFO measurement read at i2c_fifo_data, see i2cRequest()
+#endif
 
 const float Pandauino_Freq_LF_VHF::VccDivider = 10.0 / 30.0;                   	// External resistor network divider of board VCC to ADC
 const float Pandauino_Freq_LF_VHF::vref = 5.0;                                 	// ADC Reference voltage
@@ -192,6 +253,11 @@ const unsigned int Pandauino_Freq_LF_VHF::VccTestPeriod = 60;
 
 const unsigned int Pandauino_Freq_LF_VHF::vccDelayPeriod = 100;                 // Delay between vccTest when in error
 
+const unsigned int Pandauino_Freq_LF_VHF::prescalerSettleDelay = 10;            // Time to clear the prescaler buffering effect after a change of path (ms)
+const unsigned int Pandauino_Freq_LF_VHF::standbyMessageTime = 5000;            // Time the standby message is displayed before cutting the power (ms)
+const unsigned int Pandauino_Freq_LF_VHF::standbyPowerOffTime = 1000;           // Time between cutting the power and sleeping (ms)
+const unsigned int Pandauino_Freq_LF_VHF::wakeUpTime = 100;                     // Time to let the amplifier circuit charge after waking up (ms)
+
 const float Pandauino_Freq_LF_VHF::underVoltage = 7.5;                         	// Power under voltage threshold value in volts
 const float Pandauino_Freq_LF_VHF::overVoltage = 13.0;                         	// Power over voltage ceiling value in volts
 const float Pandauino_Freq_LF_VHF::hysteresisVccPerCent = 3;                   	// Power voltage hysteresis % // threshold and ceiling
@@ -217,40 +283,109 @@ measurementDisplayType Pandauino_Freq_LF_VHF::measurementType = measure_frequenc
 byte Pandauino_Freq_LF_VHF::displayPrecision = 6;                              	// The display precision. Will be set depending on resolution parameter
 float Pandauino_Freq_LF_VHF::measurementTimeCoefficient = 1.0;        					// The measure period is mutliplied by measurementTimeCoefficient to set the effective measurement time. i.e in High res = 10.0 in low res = 0.1
 algorithmType Pandauino_Freq_LF_VHF::algorithm = algorithm_freqCount;						// The algorithm used to compute the frequency, depending on the current band
+int64_t Pandauino_Freq_LF_VHF::countMultiplier = 0;															// Gated counting: calibrated uHz per counted edge, with multiplierShift fractional bits
+int64_t Pandauino_Freq_LF_VHF::periodNumerator = 0;															// Input capture: calibrated uHz * 16 MHz clock ticks of the periods measured at once
+long Pandauino_Freq_LF_VHF::calibrationPpb = 0;																	// (calibration - 1) in parts per billion plus the band one, folded into countMultiplier and periodNumerator
+long Pandauino_Freq_LF_VHF::bandCalibrationPpb[4] = {0, 0, 0, 0};								// Correction of each measurement path relative to calibration (ppb), see calibrateAll()
 float Pandauino_Freq_LF_VHF::prescalerCoef = 1.0;																// The prescaler coef, depending on the configuration of the current band
 float Pandauino_Freq_LF_VHF::effectiveHFMeasurePeriod;									// The effective perdiod used to compute HF/VHF values, depending on resolution
-int Pandauino_Freq_LF_VHF::LFTimeout;																						// Expected maximum time to measure an LF value in normal resolution
+unsigned long Pandauino_Freq_LF_VHF::LFTimeout;																					// Expected maximum time to measure an LF value (ms). When reached, frequency is supposed to be impossible to measure
+double Pandauino_Freq_LF_VHF::LFEstimate = 0.0;																	// Last LF frequency, used to size the number of periods measured at once. 0.0 if unknown
+estimatorType Pandauino_Freq_LF_VHF::estimator = estimator_mean;								// LF frequency estimator
+unsigned int Pandauino_Freq_LF_VHF::regressionCaptures = 1;											// LF: captures per measure, more than one with the regression estimator
+unsigned int Pandauino_Freq_LF_VHF::regressionIndex = 0;												// LF regression: captures in the current window
+unsigned long Pandauino_Freq_LF_VHF::regressionTime = 0;												// LF regression: ticks from the first edge of the window to the last one captured
+int64_t Pandauino_Freq_LF_VHF::regressionSumY = 0;															// LF regression: sum of the edge times (ticks)
+int64_t Pandauino_Freq_LF_VHF::regressionSumXY = 0;															// LF regression: sum of the edge numbers times the edge times
+bool Pandauino_Freq_LF_VHF::reciprocalCounting = false;													// Measures low HF band frequencies by reciprocal counting instead of gated counting
+double Pandauino_Freq_LF_VHF::reciprocalEstimate = 0.0;													// Last HF frequency, used to choose between gated and reciprocal counting. 0.0 if unknown
+double Pandauino_Freq_LF_VHF::adaptiveEstimate = 0.0;														// Last HF / VHF frequency, used to set the adaptive gate. 0.0 if unknown
+unsigned int Pandauino_Freq_LF_VHF::reciprocalPeriods = 1;											// Number of periods measured at once by reciprocal counting
+bool Pandauino_Freq_LF_VHF::bandTracking = true;																// In auto mode, keeps measuring on the last band found instead of searching it again on every measure
+bool Pandauino_Freq_LF_VHF::bandLocked = false;																	// True when the auto mode is tracking the band found by the last search
+unsigned long Pandauino_Freq_LF_VHF::bandLockStamp = 0;													// Time stamp of the last band search
+bool Pandauino_Freq_LF_VHF::continuousGating = false;														// Keeps the HF / VHF gates back to back: the counting is never restarted while the band does not change
+unsigned long Pandauino_Freq_LF_VHF::gateStamp = 0;															// Time stamp of the last gate read, 0 after the counter was (re)started
+unsigned long Pandauino_Freq_LF_VHF::gatesLost = 0;															// Number of gates overwritten before being read, i.e. breaks of the contiguous gates sequence
+unsigned long Pandauino_Freq_LF_VHF::captureStamp = 0;													// micros() of the last LF capture buffer drain, 0 when the capture was restarted
+long Pandauino_Freq_LF_VHF::captureSlack = 0;																		// LF capture time not covered by the captures read (clock ticks), see measureLF()
+unsigned long Pandauino_Freq_LF_VHF::capturesLost = 0;													// Number of LF captures lost as the FreqMeasure buffer was full
+byte Pandauino_Freq_LF_VHF::captureBacklog = 0;																	// Largest number of LF captures waiting in the FreqMeasure buffer at a freqCount() call
+gateMode Pandauino_Freq_LF_VHF::gating = gate_fixed;														// HF / VHF gated counting with one gate time or by stacking short gates
+unsigned long Pandauino_Freq_LF_VHF::stackSum[3];																// Gate stacking: counts summed for the normal, high and ultra high resolution results
+byte Pandauino_Freq_LF_VHF::stackGates[3];																			// Gate stacking: number of lower level gates summed in stackSum
+int64_t Pandauino_Freq_LF_VHF::stackedFrequency[4];															// Gate stacking: last result of each resolution (uHz), 0 if none yet
+byte Pandauino_Freq_LF_VHF::stackPublished = 0;																	// Gate stacking: results published besides the one of the resolution, bit 1 << resolution
+
+counterState Pandauino_Freq_LF_VHF::state = state_measure;											// Step of the counter state machine run by freqCount()
+unsigned long Pandauino_Freq_LF_VHF::stateStamp = 0;														// Time stamp of the last state change
+long Pandauino_Freq_LF_VHF::calibrationFrequency = 0;														// Frequency of the calibration source
+bool Pandauino_Freq_LF_VHF::calibratingAll = false;															// Calibration started by calibrateAll()
+byte Pandauino_Freq_LF_VHF::calibrationBands = 0;																// Bands (bit 1 << band) still to calibrate by calibrateAll()
+unsigned long Pandauino_Freq_LF_VHF::calibrationTimeout = 0;										// The calibration is abandoned when no measure is available after this time (ms)
+unsigned long Pandauino_Freq_LF_VHF::messageStamp = 0;													// Time stamp of the message held on the LCD
+unsigned int Pandauino_Freq_LF_VHF::messageHoldTime = 0;												// Time the message is held on the LCD, 0 if none (ms)
 
 // buffers
 measurementMode Pandauino_Freq_LF_VHF::previousMode;
 measurementBand Pandauino_Freq_LF_VHF::previousBand;
 measurementResolution Pandauino_Freq_LF_VHF::previousResolution;
-double Pandauino_Freq_LF_VHF::previousCalibration;
-measurementDisplayType Pandauino_Freq_LF_VHF::previousMeasurementType;
-operationType Pandauino_Freq_LF_VHF::previousOperation;
-sleepMode Pandauino_Freq_LF_VHF::previousSleepSetting;
+gateMode Pandauino_Freq_LF_VHF::previousGating;
+estimatorType Pandauino_Freq_LF_VHF::previousEstimator;
 
 unsigned long Pandauino_Freq_LF_VHF::countLF = 0;                              	// Low frequency clock counts
 unsigned long Pandauino_Freq_LF_VHF::countHF = 0;                              	// High frequency clock counts
 unsigned long Pandauino_Freq_LF_VHF::measureStamp = 0;                         	// Time stamp of the last measure.
 unsigned long Pandauino_Freq_LF_VHF::displayStamp = 0;                         	// Time stamp of the last displayed measurement.
 
-double Pandauino_Freq_LF_VHF::sumDisplayFreq = 0.0;                            	// Stores the sum of frequency measurements accumulated during a time lap = displayTimeLap
-long Pandauino_Freq_LF_VHF::nbAvgDisplayFreq = 0;                      	// Stores the number of frequency measurements to average during a time lap =  displayTimeLap
+int64_t Pandauino_Freq_LF_VHF::sumDisplayFreqTicks = 0;                        	// Stores the sum of the LF measurements (uHz) times their clock ticks during a time lap = displayTimeLap
+unsigned long Pandauino_Freq_LF_VHF::sumDisplayTicks = 0;                      	// Stores the sum of the clock ticks of the LF measurements during a time lap =  displayTimeLap
 
 double Pandauino_Freq_LF_VHF::frequency = 0.0;                                 	// Computed frequency
-double Pandauino_Freq_LF_VHF::frequencyTestVHF2 = 0.0;                         	// Computed frequency when testing in the VHF2 band
-double Pandauino_Freq_LF_VHF::frequencyTestVHF1 = 0.0;                         	// Computed frequency when testing in the VHF1 band
-double Pandauino_Freq_LF_VHF::frequencyTestHF = 0.0;														// Computed frequency when testing in the HF band
-double Pandauino_Freq_LF_VHF::frequencyTest = 0.0;
+int64_t Pandauino_Freq_LF_VHF::frequencyMicroHertz = 0;                        	// Computed frequency (uHz). frequency is only given for the getFrequency() API
+
+storedMeasurement Pandauino_Freq_LF_VHF::measurementRing[MEASUREMENT_RING_SIZE];	// Last measurements not read yet by readMeasurements()
+volatile byte Pandauino_Freq_LF_VHF::ringHead = 0;															// Next record written. Only changed by pushMeasurement()
+volatile byte Pandauino_Freq_LF_VHF::ringTail = 0;															// Next record read. Only changed by readMeasurements()
+unsigned long Pandauino_Freq_LF_VHF::ringOverflows = 0;												// Number of measurements lost because the ring buffer was full
+
+filterSettings Pandauino_Freq_LF_VHF::bandFilter[4] = {{0, 1, 0}, {0, 1, 0}, {0, 1, 0}, {0, 1, 0}};		// Filters of each band, all off
+int64_t Pandauino_Freq_LF_VHF::filterHistory[FILTER_MEDIAN_SIZE];								// Last measures (uHz) for the running median
+measurementBand Pandauino_Freq_LF_VHF::filterBand = band_LF;										// Band of the measures in the filters
+byte Pandauino_Freq_LF_VHF::filterCount = 0;																		// Number of measures in filterHistory
+byte Pandauino_Freq_LF_VHF::filterIndex = 0;																		// Next measure written in filterHistory
+int64_t Pandauino_Freq_LF_VHF::filterAverage = 0;																// Exponential moving average (uHz), 0 when empty
+byte Pandauino_Freq_LF_VHF::glitchRejects = 0;																	// Successive measures rejected as glitches
+unsigned long Pandauino_Freq_LF_VHF::filterRejects = 0;													// Number of measures rejected as glitches since the start
+
+unsigned long Pandauino_Freq_LF_VHF::statisticsCount = 0;												// Number of measures in the running statistics
+int64_t Pandauino_Freq_LF_VHF::statisticsMinimum = 0;														// Lowest measure (uHz)
+int64_t Pandauino_Freq_LF_VHF::statisticsMaximum = 0;														// Highest measure (uHz)
+int64_t Pandauino_Freq_LF_VHF::statisticsMean = 0;															// Running mean (uHz << statisticsMeanShift)
+uint64_t Pandauino_Freq_LF_VHF::statisticsM2 = 0;																// Sum of the squared deviations to the mean, in (2^statisticsShift uHz)^2
+byte Pandauino_Freq_LF_VHF::statisticsShift = 0;																// Scale of statisticsM2, raised when it would overflow
+double Pandauino_Freq_LF_VHF::frequencyTestVHF2 = 0.0;                         	// Coarse frequency given by the auto mode probe on the VHF2 (/32) path
+int64_t Pandauino_Freq_LF_VHF::frequencyTest = 0;																// Last measure (uHz), 0 if none
 
 operationType Pandauino_Freq_LF_VHF::operation = operation_none;								// Operation to do on the brute frequency value
-double Pandauino_Freq_LF_VHF::lastValidFrequency = 0.0;                         // Last frequency that was displayed
-double Pandauino_Freq_LF_VHF::refFrequency = 0.0;                              	// Reference frequency to use in the operation
-double Pandauino_Freq_LF_VHF::resultFrequency = 0.0;							  						// Frequency +/- operation.
+int64_t Pandauino_Freq_LF_VHF::lastValidFrequency = 0;                          // Last frequency that was displayed (uHz)
+int64_t Pandauino_Freq_LF_VHF::refFrequency = 0;                               	// Reference frequency to use in the operation (uHz)
+int64_t Pandauino_Freq_LF_VHF::resultFrequency = 0;							  							// Frequency +/- operation (uHz)
 
 bool Pandauino_Freq_LF_VHF::outputToSerial =  false;                           	// True to print to serial port.
 long Pandauino_Freq_LF_VHF::bauds = 57600;                            					// Serial monitor baud rate
+serialFormat Pandauino_Freq_LF_VHF::outputFormat = serial_ascii;								// Format of the serial output
+unsigned int Pandauino_Freq_LF_VHF::measurementSequence = 0;										// Incremented on every new measurement. Gaps in the binary frames sequence show the frames lost
+unsigned long Pandauino_Freq_LF_VHF::rawCount = 0;															// Counter value of the last measure: edges in gated counting, 16 MHz clock ticks in input capture
+unsigned long Pandauino_Freq_LF_VHF::gateTime = 0;															// Time span of the last measure (us)
+byte Pandauino_Freq_LF_VHF::frame[26];																					// Binary frame buffer
+
+#ifdef FREQ_ENABLE_I2C
+byte Pandauino_Freq_LF_VHF::i2cAddress = 0;																			// I2C slave address, 0 when the slave mode is off
+byte Pandauino_Freq_LF_VHF::i2cSnapshot[i2c_register_end];												// I2C registers read by the Wire interrupt, see updateI2CSnapshot()
+volatile byte Pandauino_Freq_LF_VHF::i2cPointer = 0;														// I2C register pointer
+volatile byte Pandauino_Freq_LF_VHF::i2cControl = 0;														// Last i2c_control write, applied by serviceI2C()
+#endif
 
 float Pandauino_Freq_LF_VHF::calManValue = -9.0;																// Manual calibration value used to set the calibration value
 
@@ -264,20 +399,58 @@ sleepMode Pandauino_Freq_LF_VHF::sleepSetting = sleep_5m;												// Sleep co
 
 double Pandauino_Freq_LF_VHF::calibration = 1.0;                          			// Tweak it to precisely calibrate your board as compared to a very precise frequency reference, by the program or manually
 
-// EEPROM Addresses
-byte Pandauino_Freq_LF_VHF::addressOfMode = EEPROMbaseAddress + sizeof(eepromInit);
-byte Pandauino_Freq_LF_VHF::addressOfBand = addressOfMode + sizeof(mode);
-byte Pandauino_Freq_LF_VHF::addressOfResolution = addressOfBand + sizeof(band);
-byte Pandauino_Freq_LF_VHF::addressOfCalibration = addressOfResolution + sizeof(resolution);
-byte Pandauino_Freq_LF_VHF::addressOfMeasurementType = addressOfCalibration + sizeof(calibration);
-byte Pandauino_Freq_LF_VHF::addressOfOperation = addressOfMeasurementType + sizeof(measurementType);
-byte Pandauino_Freq_LF_VHF::addressOfSleepSetting = addressOfOperation + sizeof(operation);
-byte Pandauino_Freq_LF_VHF::addressOfRefFrequency = addressOfSleepSetting + sizeof(sleepSetting);
-
-//Buffers used to render lcd messages
-char Pandauino_Freq_LF_VHF::text1[17] = "";
-String Pandauino_Freq_LF_VHF::text = "";
+// Settings journal in EEPROM
+byte Pandauino_Freq_LF_VHF::settingsBuffer[41];																	// Record being written or read
+byte Pandauino_Freq_LF_VHF::settingsSlot = 0;																		// Slot of the last record
+unsigned long Pandauino_Freq_LF_VHF::settingsSequence = 0;											// Sequence number of the last record
+byte Pandauino_Freq_LF_VHF::settingsWriteIndex = 42;														// Steps of the record write done, see settingsStep(). 42 when no write is running
+bool Pandauino_Freq_LF_VHF::settingsDirty = false;															// The settings changed since the last record
+unsigned long Pandauino_Freq_LF_VHF::settingsStamp = 0;													// Time (millis) of the last settings change
+
+// Timebase disciplining from a 1 PPS input
+disciplineState Pandauino_Freq_LF_VHF::discipline = discipline_off;						// State of the disciplining
+volatile unsigned long Pandauino_Freq_LF_VHF::ppsStamp = 0;											// micros() of the last pulse, set by ppsInterrupt()
+volatile byte Pandauino_Freq_LF_VHF::ppsCount = 0;															// Pulses received, set by ppsInterrupt()
+byte Pandauino_Freq_LF_VHF::ppsLastCount = 0;																		// ppsCount at the last pulse processed by disciplineStep()
+unsigned long Pandauino_Freq_LF_VHF::ppsLastStamp = 0;													// micros() of the last pulse processed
+unsigned long Pandauino_Freq_LF_VHF::ppsBlockStamp = 0;													// micros() of the first pulse of the current block
+byte Pandauino_Freq_LF_VHF::ppsBlockCount = 0;																	// Seconds in the current block
+bool Pandauino_Freq_LF_VHF::ppsBlockValid = false;															// False until the first pulse starts a block
+unsigned long Pandauino_Freq_LF_VHF::ppsMillis = 0;															// Time (millis) of the last pulse processed
+long Pandauino_Freq_LF_VHF::disciplineAccumulator = 0;													// Loop filter state: the estimate with disciplineFilterShift fractional bits
+long Pandauino_Freq_LF_VHF::disciplinePpb = 0;																	// Estimated timebase error (ppb), positive when the MCU clock is fast
+byte Pandauino_Freq_LF_VHF::disciplineBlocks = 0;																// Number of blocks measured, up to 255
+byte Pandauino_Freq_LF_VHF::lockCount = 0;																			// Successive measures within disciplineLockPpb of the estimate, up to 255
+
+#ifdef FREQ_ENABLE_ADEV
+bool Pandauino_Freq_LF_VHF::allanEnabled = false;																// Allan deviation of the gate results, see setAllanDeviation()
+bool Pandauino_Freq_LF_VHF::allanPrint = false;																	// The Allan deviation lines are printed in serial_ascii format
+long Pandauino_Freq_LF_VHF::allanHistory[ALLAN_HISTORY];												// Last gate results, as deviations from allanReference (uHz)
+byte Pandauino_Freq_LF_VHF::allanIndex = 0;																			// Next gate result written in allanHistory
+unsigned long Pandauino_Freq_LF_VHF::allanCount = 0;														// Gate results since the restart
+int64_t Pandauino_Freq_LF_VHF::allanReference = 0;															// First gate result since the restart (uHz)
+unsigned long Pandauino_Freq_LF_VHF::allanGateTime = 0;													// Gate time of the results, tau0 (us)
+uint64_t Pandauino_Freq_LF_VHF::allanSum[ALLAN_OCTAVES];												// Sums of the squared differences of successive averages over 2^octave gates, in (2^allanShift uHz)^2
+byte Pandauino_Freq_LF_VHF::allanShift[ALLAN_OCTAVES];													// Scale of allanSum, raised when it would overflow
+unsigned long Pandauino_Freq_LF_VHF::allanValue[ALLAN_OCTAVES];									// Last Allan deviations reported (1E-12), 0 when not available
+byte Pandauino_Freq_LF_VHF::allanReportOctave = 0;															// Next octave reported by allanStep()
+unsigned long Pandauino_Freq_LF_VHF::allanReportStamp = 0;											// millis() of the last report
+unsigned long Pandauino_Freq_LF_VHF::allanReportedCount = 0;										// allanCount at the last report
+#endif
+
+unsigned long Pandauino_Freq_LF_VHF::settleMaxDrift = 0;												// Largest drift rate of a settled frequency (uHz/s), 0 when the settling detector is off
+unsigned long Pandauino_Freq_LF_VHF::settleTime = 0;														// Time the drift rate must stay under settleMaxDrift (ms)
+bool Pandauino_Freq_LF_VHF::settlePrint = false;																// The drift rate lines are printed in serial_ascii format
+int64_t Pandauino_Freq_LF_VHF::driftFrequency = 0;															// lastValidFrequency at the start of the current drift rate measure (uHz), 0 when none
+unsigned long Pandauino_Freq_LF_VHF::driftStamp = 0;														// millis() of driftFrequency
+int64_t Pandauino_Freq_LF_VHF::driftRate = 0;																		// Averaged drift rate (uHz/s)
+bool Pandauino_Freq_LF_VHF::driftValid = false;																	// driftRate holds at least one measure
+unsigned long Pandauino_Freq_LF_VHF::settledStamp = 0;													// millis() when the drift rate went under settleMaxDrift
+bool Pandauino_Freq_LF_VHF::settled = false;																		// The frequency is settled
+
+//Buffer used to render lcd messages
 char Pandauino_Freq_LF_VHF::line1[17] = "";
+char Pandauino_Freq_LF_VHF::lcdShadow[16];                         // The 16 characters currently on the LCD
 
 
 
@@ -308,6 +481,8 @@ void Pandauino_Freq_LF_VHF::configureComputation(measurementMode _mode, measurem
 	mode = _mode;
 	band = _band;
 	resolution = _resolution;
+	resetStatistics();
+	resetDrift();
 	configureComputation(true);
 }
 
@@ -323,7 +498,7 @@ void Pandauino_Freq_LF_VHF::stopComputation() {
 // ************************************************************************************************************************************
 // freqSetup
 // Called in the Arduino Setup section to initialize the board and software
-void Pandauino_Freq_LF_VHF::freqSetup(boardType _boardVersion, boolean _outputToSerial = false, long _bauds = 57600) {
+void Pandauino_Freq_LF_VHF::freqSetup(boardType _boardVersion, bool _outputToSerial, long _bauds) {
 
 	boardVersion = _boardVersion;
 	outputToSerial = _outputToSerial;
@@ -352,6 +527,7 @@ void Pandauino_Freq_LF_VHF::freqSetup(boardType _boardVersion, boolean _outputTo
   // set up the LCD's number of columns and rows:
   // It's 16*1 but factory configured as 8*2 (1 line)
   lcd.begin(8, 2);
+  invalidateLCDShadow();
   printSixteenCharToLCD(initMessage);
 
   // Vcc test
@@ -364,7 +540,7 @@ void Pandauino_Freq_LF_VHF::freqSetup(boardType _boardVersion, boolean _outputTo
   button.attachLongPressStart(buttonPress);
 
   // Loads parameters
-  readAllFromEEPROM();
+  loadSettings();
   setSleepTimeout();
 
 	// sets up the prescaler and parameters for the given band and starts the algortithm
@@ -375,277 +551,197 @@ void Pandauino_Freq_LF_VHF::freqSetup(boardType _boardVersion, boolean _outputTo
 //************************************************************************************************************************************
 // freqCount
 // Called in the Arduino Loop section to run the measurement and manage user actions
+// It never waits for a measurement: each call runs one step of the counter state machine and returns
 void Pandauino_Freq_LF_VHF::freqCount() {
 
-  // Checks machine state of menu button
-  button.tick();
+#ifdef FREQ_ENABLE_I2C
+	if (i2cAddress != 0) serviceI2C();
+#endif
 
-  if (editMode==display_main) { // i.e. not in the menu
+	settingsStep();
 
-	  // Tests VCC periodically
-	  // !!! PB influence PC1
-	  // A VERIFIER
-	  //
+	disciplineStep();
 
-	  if (timeToTestVCC()) {
-//			stopComputation();
-	    VccTest();
-	    if (mode == mode_auto) {configureComputation(true);}
-			measureStamp = millis();
-	  };
+#ifdef FREQ_ENABLE_ADEV
+	allanStep();
+#endif
 
-    // if sleepTimeout reached places the board in power saving mode
-    if ((sleepSetting != sleep_disabled) && ((millis() - displayStamp)  > sleepTimeout)) {
-      standbyMode();
-    };
+	// ******** calibration and standby run on their own, without the menu button *****
+	if ((state == state_calibration_skip) || (state == state_calibration_gate)) {
+		calibrationStep();
+		return;
+	}
 
-		// ******** mode band **************************************
-		if (mode == mode_band) { // The band was chosen by the user or determined in the band detection section
+	if ((state == state_standby_message) || (state == state_standby_off) || (state == state_wake_up)) {
+		standbyStep();
+		return;
+	}
 
-			if (band == band_LF) { //  LF
+  // Checks machine state of menu button
+  button.tick();
 
-				// DEBUG
-				//Serial.println("mode_band LF");
+	// Ends a message held on the LCD
+	releaseMessage();
 
-				frequencyTest = measureLF();
+  if (editMode != display_main) return;	// i.e. in the menu
 
-				if (frequencyTest > 0.0) {
+	// ******** power error: only checks periodically if Vcc is back ***********
+	if (state == state_voltage_error) {
 
-					frequency = frequencyTest;
+		if ((millis() - stateStamp) > vccDelayPeriod) {
+			VccCheck();
+			stateStamp = millis();
+			if (!voltageError) {
+				configureComputation(true);
+				measureStamp = millis();
+			}
+		}
+		return;
+	}
 
-					// DEBUG
-					// Serial.print("LF measure: ");
-					// Serial.println(frequency);
+  // Tests VCC periodically
+  if (timeToTestVCC()) {
+    VccCheck();
+    if (voltageError) {
+			state = state_voltage_error;
+			stateStamp = millis();
+			return;
+    }
+    if ((mode == mode_auto) && !continuousGating) {configureComputation(true);}
+		measureStamp = millis();
+  };
 
-					displayMeasurement();
-					measureStamp = millis();
-				}
+  // if sleepTimeout reached places the board in power saving mode
+  if ((sleepSetting != sleep_disabled) && ((millis() - displayStamp)  > sleepTimeout)) {
+    standbyMode();
+    return;
+  };
 
-				if ((millis() - measureStamp) > LFTimeout) {
-	  		  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
-	  		  measureStamp = millis();
-				}
+	// ******** band search in auto mode ***************************
+	if (state != state_measure) {
+		searchStep();
+		return;
+	}
 
-			} // LF
+	// ******** mode band **************************************
+	if (mode == mode_band) { // The band was chosen by the user or determined in the band detection section
 
-			else { // i.e. HF VHF
+		if (band == band_LF) { //  LF
 
-				frequencyTest = measureHF_VHF();
-				if (frequencyTest > 0.0) {
-					frequency = frequencyTest;
-					displayMeasurement();
-					measureStamp = millis();
-				}
+			// DEBUG
+			//Serial.println("mode_band LF");
 
-				if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-	  		  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
-	  		  measureStamp = millis();
-				}
+			frequencyTest = measureLF();
 
-			} // HF VHF
+			if (frequencyTest > 0) {
 
-		} // mode_band
+				// DEBUG
+				// Serial.print("LF measure: ");
+				// Serial.println(frequencyTest);
 
+				newMeasurement(frequencyTest);
+				measureStamp = millis();
+			}
 
-  	// ******** mode auto / LF ************************************
-  	else if ((mode == mode_auto) && (band == band_LF))  {
+			if ((millis() - measureStamp) > LFTimeout) {
+  		  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
+  		  measureStamp = millis();
 
-			//DEBUG
-			//Serial.println("mode_auto LF");
+				// The frequency may have dropped: starts again from a single period
+				if (LFEstimate > 0.0) {
+					LFEstimate = 0.0;
+					configureComputation(true);
+				}
+			}
 
-			frequencyTest = measureLF();
+		} // LF
 
-			if (frequencyTest > 0.0) {
+		else { // i.e. HF VHF
 
+			frequencyTest = measureHF_VHF();
+			if (frequencyTest > 0) {
+				newMeasurement(frequencyTest);
 				measureStamp = millis();
-
-			//DEBUG
-			//Serial.println("frequencyTest: ");
-			//Serial.println(frequencyTest);
-
-				if (frequencyTest > freqLFmax) { 	// Frequency too high goes to HF/VHF computing
-					band = band_HF;
-					stopComputation();
-				} else { 													// valid frequency
-					frequency = frequencyTest;
-					displayMeasurement();
-				}
 			}
 
-			if ((millis() - measureStamp) > LFTimeout) {
-				band = band_HF; 		// Goes to HF/VHF mode_auto computing
-	  	  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
-				stopComputation();
-	  	  measureStamp = millis();
+			if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
+  		  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
+  		  measureStamp = millis();
 			}
 
-  	// ******** mode auto in HF / VHF1 / VHF2 *********************
-  	} else {
+		} // HF VHF
 
-			frequencyTestVHF2 = 0.0;
-			frequencyTestVHF1 = 0.0;
-			frequencyTestHF = 0.0;
+	} // mode_band
 
-			// Testing VHF1 annd VHF2 band only for the VHF board version
-			if (boardVersion == board_version_vhf) {
 
-	  		// Here we determine the effective band
-	  		// using freqCount in VHF2 then VHF1 then HF to check if the measure is in these ranges
-	  		// If the value is in the LF range switch to LF
+	// ******** mode auto / LF ************************************
+	else if ((mode == mode_auto) && (band == band_LF))  {
 
-				// *********** Testing in the 20-210 MHz band
-			  band = band_VHF2;
-				configureComputation(true);
-				delay(10); // to clear the prescaler buffering effect
+		//DEBUG
+		//Serial.println("mode_auto LF");
 
-/*
-				// run once to clear the freqCount "buffer"
-				frequencyTestVHF2 = 0.0;
-				measureStamp = millis();
+		frequencyTest = measureLF();
 
-				while (frequencyTestVHF2 == 0.0) { // waits for a measurement
-					frequencyTestVHF2 = measureHF_VHF();
-					if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-						break;				// Goes to next computation
-					}
-  				// Checks machine state of menu button so the menu can be called when in this loop
-  				button.tick();
-					// If the menu was called by button.tick() during these frequency tests , exits
-					if (editMode != display_main) return;
-				 	delay(10);
-				}
-*/
-				// now trying to measure a valid frequency
-				frequencyTestVHF2 = 0.0;
-				measureStamp = millis();
+		if (frequencyTest > 0) {
 
-				while (frequencyTestVHF2 == 0.0) { // waits for a measurement
-					frequencyTestVHF2 = measureHF_VHF();
-					if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-						break;				// Goes to next computation
-					}
-  				button.tick();
-					if (editMode != display_main) return;
-				 	delay(10);
-				}
+			measureStamp = millis();
 
+		//DEBUG
+		//Serial.println("frequencyTest: ");
+		//Serial.println(frequencyTest);
 
-				// *********** Testing in the 5-20 MHz band
-			  band = band_VHF1;
-				configureComputation(true);
-				delay(10); // to clear the prescaler buffering effect
-				frequencyTestVHF1 = 0.0;
-				measureStamp = millis();
+			if (frequencyTest > freqLFmax * 1000000) { 	// Frequency too high goes to HF/VHF computing
+				band = band_HF;
+				stopComputation();
+			} else { 													// valid frequency
+				newMeasurement(frequencyTest);
+			}
+		}
 
-/*
-				// run once to clear the freqCount "buffer"
-				while (frequencyTestVHF1 == 0.0) { // waits for a measurement
-					frequencyTestVHF1 = measureHF_VHF();
-					if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-						break;				// Goes to next computation
-					}
-  				button.tick();
-					if (editMode != display_main) return;
-				 	delay(10);
-				}
-*/
-				// now trying to measure a valid frequency
-				frequencyTestVHF1 = 0.0;
-				measureStamp = millis();
+		if ((millis() - measureStamp) > LFTimeout) {
+			band = band_HF; 		// Goes to HF/VHF mode_auto computing
+			LFEstimate = 0.0;
+  	  printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
+			stopComputation();
+  	  measureStamp = millis();
+		}
 
-				while (frequencyTestVHF1 == 0.0) { // waits for a measurement
-					frequencyTestVHF1 = measureHF_VHF();
-					if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-						break;				// Goes to next computation
-					}
-  				button.tick();
-					if (editMode != display_main) return;
-				 	delay(10);
-				}
+	// ******** mode auto tracking the last HF / VHF1 / VHF2 band found *****
+	} else if ((mode == mode_auto) && (bandLocked == true)) {
 
-			} // End testing VHF1/VHF2 only for VHF boards
+		// Measures only on the band found by the last search, as in mode_band.
+		// Falls back to a full search when the reading leaves the band limits plus hysteresis,
+		// when no measure is available or when the band has to be re-verified.
 
-			// *********** Testing in the 5 KHz -5 MHz band
-		  band = band_HF;
-			configureComputation(true);
-			delay(10); // to clear the prescaler buffering effect
-			frequencyTestHF = 0.0;
-			measureStamp = millis();
+		frequencyTest = measureHF_VHF();
 
-/*
-			// run once to clear the freqCount "buffer"
-			while (frequencyTestHF == 0.0) { // waits for a measurement
-				frequencyTestHF = measureHF_VHF();
-				if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-					break;				// Goes to next computation
-				}
-  			button.tick();
-				if (editMode != display_main) return;
-			 	delay(10);
-			}
-*/
+		if (frequencyTest > 0) {
 
-			// now trying to measure a valid frequency
-			frequencyTestHF = 0.0;
 			measureStamp = millis();
 
-			while (frequencyTestHF == 0.0) { // waits for a measurement
-				frequencyTestHF = measureHF_VHF();
-				if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
-					break;				// Goes to next computation
-				}
-  			button.tick();
-				if (editMode != display_main) return;
-			 	delay(10);
+			if (frequencyInBand(frequencyTest / 1000000.0, band, bandHysteresisPerCent)) {
+				newMeasurement(frequencyTest);
+			} else {
+				bandLocked = false;
 			}
+		}
 
-			// We tested VH2, VHF1 and HF
-			// We consider the highest frequency in case it was folded
-			// Keep it, in case there was an aberration with for example a VHF1 freq above VHF2 freq beacuse of folding
-			// DEBUG
-			/*
-			Serial.print("HF: ");
-			Serial.println(frequencyTestHF);
-			Serial.print("VHF1: ");
-			Serial.println(frequencyTestVHF1);
-			Serial.print("VHF2: ");
-			Serial.println(frequencyTestVHF2);
-			*/
-
-			frequencyTest = frequencyTestHF;
-			if (frequencyTestVHF1 > frequencyTest) { frequencyTest = frequencyTestVHF1;}
-			if (frequencyTestVHF2 > frequencyTest) { frequencyTest = frequencyTestVHF2;}
-
-			// But we use the value computed in its right corresponding band to avoid quantization error because of prescaling
-			if ((boardVersion == board_version_hf) || ((freqHFmin <= frequencyTest) && (frequencyTest < freqVHF1min)))
-				{ band= band_HF; frequencyTest = frequencyTestHF;}
-			else if ((freqVHF1min <= frequencyTest) && (frequencyTest < freqVHF2min))
-				{ band= band_VHF1;  frequencyTest = frequencyTestVHF1;}
-			else
-				{band = band_VHF2;  frequencyTest = frequencyTestVHF2;}
-
-			// if frequency zero or in the LF range switch to LF computing.
-			if (frequencyTest < freqLFmax) {
-
-				band = band_LF;
-				configureComputation(true);
-				measureStamp = millis(); // false measureStamp to let LF measurement run
+		if ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30)) {
+			bandLocked = false;
+		}
 
-			} else {
+		if (((millis() - bandLockStamp) > bandVerifyPeriod) && !continuousGating) {
+			bandLocked = false;
+		}
 
-				// displays the final value
-				frequency = frequencyTest;
-				// DEBUG
-				//Serial.print("frequency: ");
-				//Serial.println(frequency);
-				displayMeasurement();
+	// ******** mode auto in HF / VHF1 / VHF2: starts a band search *****
+	} else {
 
-			} 	// switch to LF or not
-		} 		// mode auto in HF / VHF1 / VHF2
-	} 			// (editMode==display_main)
+		searchStep();
 
-}
+	}
 
+}
 
 // ************************************************************************************************************************************
 //  getFrequency / readFrequency
@@ -653,6 +749,11 @@ double Pandauino_Freq_LF_VHF::getFrequency() {
   return frequency;
 }
 
+// The same without the float rounding: calibrated frequency in uHz
+int64_t Pandauino_Freq_LF_VHF::getFrequencyMicroHertz() {
+  return frequencyMicroHertz;
+}
+
 // After reading frequency it is zeroed so the user knows when a new value is available
 double Pandauino_Freq_LF_VHF::readFrequency() {
   double freq = frequency;
@@ -660,139 +761,302 @@ double Pandauino_Freq_LF_VHF::readFrequency() {
   return freq;
 }
 
+// ************************************************************************************************************************************
+//  Measurement ring buffer
+// Every measurement is also stored with its time stamp in a ring buffer of MEASUREMENT_RING_SIZE - 1 records
+// so that none is lost between two reads.
+
+// Number of measurements waiting in the ring buffer
+byte Pandauino_Freq_LF_VHF::measurementsAvailable() {
+  return (ringHead - ringTail) & (MEASUREMENT_RING_SIZE - 1);
+}
+
+// Copies up to maxRecords measurements, oldest first, and removes them from the ring buffer. Returns the number copied
+byte Pandauino_Freq_LF_VHF::readMeasurements(measurementRecord records[], byte maxRecords) {
+
+  byte nbRecords = 0;
+  byte tail = ringTail;
+  byte head = ringHead;
+
+  while ((tail != head) && (nbRecords < maxRecords)) {
+    records[nbRecords].timestamp = measurementRing[tail].timestamp;
+    records[nbRecords].band = measurementRing[tail].band;
+    records[nbRecords].rawCount = measurementRing[tail].rawCount;
+    records[nbRecords].gateTime = measurementRing[tail].gateTime;
+    records[nbRecords].value = ((int64_t)measurementRing[tail].valueHigh << 32) | measurementRing[tail].valueLow;
+    nbRecords++;
+    tail = (tail + 1) & (MEASUREMENT_RING_SIZE - 1);
+  }
+
+  asm volatile("" ::: "memory");		// the records are copied before they are freed
+  ringTail = tail;
+  return nbRecords;
+}
+
+// Number of measurements lost because the ring buffer was full
+unsigned long Pandauino_Freq_LF_VHF::getMeasurementOverflows() {
+  return ringOverflows;
+}
+
+// ************************************************************************************************************************************
+//  setBandTracking
+// In auto mode, when enabled, the band found is kept and only re-searched when the frequency leaves it
+void Pandauino_Freq_LF_VHF::setBandTracking(bool _bandTracking) {
+  bandTracking = _bandTracking;
+  if (bandTracking == false) bandLocked = false;
+}
+
 // *********************************************************************************************************
 // standbyMode()
 // invoked when sleepTimeout reached or on demand
-// places the board in low power consumption mode
+// starts the sequence placing the board in low power consumption mode. The sequence is run by freqCount()
 void Pandauino_Freq_LF_VHF::standbyMode() {
 
   // debug
   //Serial.println(F("Enter sleep mode"));
-  //delay(100);
 
   printSixteenCharToLCD(const_cast<char*>(goingStandby));
-  delay(5000);
 
-  // Turn off LCD display
-  lcd.noDisplay();
+	state = state_standby_message;
+	stateStamp = millis();
 
-  // Turn off power to LCD and 6.7V regulator
-  digitalWrite(lcdLedPowerPin, LOW);          // lcd power cut
-  digitalWrite(VccReg65EnablePin, LOW);       // 6.5V regulator disabled
+}
 
-  delay(1000);
-  // ready to sleep
-  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+// ************************************************************************************************************************************
+//  Serial
+void Pandauino_Freq_LF_VHF::beginSerial(long bds) {
+  bauds = bds;
+  Serial.begin(bauds);
+  outputToSerial = true;
+}
 
-  attachInterrupt(digitalPinToInterrupt(PUSHBUTTON), pushButtonInterrupt, LOW);    // attaches an interrupt on PUSHBUTTON pin
+void Pandauino_Freq_LF_VHF::endSerial() {
+  Serial.end();
+  outputToSerial = false;
+}
 
-  // put to sleep
-  sleep_mode();
+// serial_ascii prints the displayed value, serial_binary sends a frame per measurement
+void Pandauino_Freq_LF_VHF::setSerialFormat(serialFormat _outputFormat) {
+  outputFormat = _outputFormat;
+}
 
-  // ****************
-  // wake up here
-  detachInterrupt(digitalPinToInterrupt(PUSHBUTTON)); // avoid continuous firing
+// ************************************************************************************************************************************
+//  I2C slave mode
+// Only built with -DFREQ_ENABLE_I2C, so that the Wire library and its buffers are not linked in the sketches not using it.
+// The board joins the I2C bus at address and serves the register map of i2cRegister to a master:
+// a write sets the register pointer with its first byte and may then write i2c_control,
+// a read returns the registers from the pointer (at most 32 bytes, the Wire buffer) or one FIFO measurement at i2c_fifo_data.
+// The FIFO is the measurement ring buffer: readMeasurements() must not be used at the same time.
+#ifdef FREQ_ENABLE_I2C
+void Pandauino_Freq_LF_VHF::beginI2C(byte address) {
+  i2cAddress = address;
+  i2cPointer = 0;
+  i2cControl = 0;
+  updateI2CSnapshot(false, 0);
+  Wire.begin(address);
+  Wire.onReceive(i2cReceive);
+  Wire.onRequest(i2cRequest);
+}
 
-  // frequency re-initialized
-  frequency = 0;
+void Pandauino_Freq_LF_VHF::endI2C() {
+  Wire.end();
+  i2cAddress = 0;
+}
+#endif
 
-  digitalWrite(lcdLedPowerPin, HIGH);          // lcd power on
-  digitalWrite(VccReg65EnablePin, HIGH);       // 6.5V regulator enabled
+// ************************************************************************************************************************************
+//  Timebase disciplining
+// Time tags a 1 PPS input, such as the one of a GPS receiver, on pin 11, 12 or 13 and continuously estimates the error of the 16 MHz timebase.
+// Once locked the estimate replaces calibration and is updated on the fly, see disciplineStep().
+// endDiscipline() leaves calibration to the last estimate.
+// The pulses are taken by the PCINT0 pin change interrupt: these functions only exist when the library is built with -DFREQ_PPS_ON_PCINT0
+#ifdef FREQ_PPS_ON_PCINT0
+void Pandauino_Freq_LF_VHF::beginDiscipline(byte pin) {
+
+	ppsBlockValid = false;
+	ppsLastCount = ppsCount;
+	ppsMillis = millis();
+	disciplineBlocks = 0;
+	lockCount = 0;
+	discipline = discipline_acquiring;
+
+	halBeginPPS(pin, ppsInterrupt);
+}
 
-  lcd.display();
+void Pandauino_Freq_LF_VHF::endDiscipline() {
+	halEndPPS();
+	discipline = discipline_off;
+}
+#endif
 
-  // Let the amplifier circuit charge.
-  delay(100);
-  measureStamp = millis();                // false measureStamp to avoid falling into sleep again
+disciplineState Pandauino_Freq_LF_VHF::getDisciplineState() {
+	return discipline;
+}
 
+// Estimated error of the timebase (ppb), positive when the MCU clock is fast. 0 until a first block of pulses is measured
+long Pandauino_Freq_LF_VHF::getTimebaseErrorPpb() {
+	return disciplinePpb;
 }
 
 // ************************************************************************************************************************************
-//  Serial
-void Pandauino_Freq_LF_VHF::beginSerial(long bds) {
-  bauds = bds;
-  Serial.begin(bauds);
-  outputToSerial = true;
+//  Allan deviation
+// Only built with -DFREQ_ENABLE_ADEV. When enabled, the contiguous HF / VHF gate results feed an overlapping Allan deviation at tau = tau0 x 2^octave, octave 0 to ALLAN_OCTAVES - 1,
+// tau0 being the gate time of the counter (10 ms in gate_stacked mode). Only a few accumulators and the last ALLAN_HISTORY results are kept.
+// It restarts when a gate is lost, the counter restarts or the gate time changes: use mode_band, or mode_auto with continuous gating.
+// Every allanReportPeriod the values are updated in the I2C registers and, with printToSerial, printed as "ADEV <tau> ms <deviation>" lines
+// between the frequencies in serial_ascii format.
+#ifdef FREQ_ENABLE_ADEV
+void Pandauino_Freq_LF_VHF::setAllanDeviation(bool enabled, bool printToSerial) {
+	allanEnabled = enabled;
+	allanPrint = printToSerial;
+	resetAllan();
 }
 
-void Pandauino_Freq_LF_VHF::endSerial() {
-  Serial.end();
-  outputToSerial = false;
+// Fractional frequency deviation at getAllanTau(octave). 0.0 until 2 x 2^octave gate results are available
+double Pandauino_Freq_LF_VHF::getAllanDeviation(byte octave) {
+
+	unsigned int m = 1 << octave;
+
+	if ((octave >= ALLAN_OCTAVES) || (allanCount < 2UL * m) || (allanReference <= 0)) return 0.0;
+
+	// sigma^2 = <(sum of the next m results - sum of the previous m)^2> / (2 m^2 f^2)
+	return (double)squareRoot(allanSum[octave] / (allanCount - 2UL * m + 1)) * (double)(1UL << allanShift[octave])
+			/ (1.41421356 * m * (double)allanReference);
+}
+
+// Averaging time of an octave (s)
+double Pandauino_Freq_LF_VHF::getAllanTau(byte octave) {
+	return allanGateTime / 1000000.0 * (1UL << octave);
+}
+#endif
+
+// ************************************************************************************************************************************
+//  Settling detector
+// Measures the drift rate of the displayed frequency and flags it as settled once the drift rate stayed under maxDrift (Hz/s)
+// for settleTime (ms), e.g. setSettling(0.1, 60000) to wait for the warm-up of a crystal oscillator. maxDrift = 0 turns it off.
+// The drift rate noise is about the displayed resolution per second: maxDrift has to be above it.
+// The flag is shown by a '*' after the unit on the LCD and in the i2c_settled register. With printToSerial, it is also sent as
+// "SETTLED <drift rate>" / "SETTLING <drift rate>" lines between the frequencies in serial_ascii format, see updateDrift().
+void Pandauino_Freq_LF_VHF::setSettling(double maxDrift, unsigned long _settleTime, bool printToSerial) {
+	settleMaxDrift = maxDrift * 1000000.0;
+	settleTime = _settleTime;
+	settlePrint = printToSerial;
+	resetDrift();
+}
+
+// Drift rate of the displayed frequency (Hz/s), 0.0 until measured
+double Pandauino_Freq_LF_VHF::getDriftRate() {
+	return driftRate / 1000000.0;
+}
+
+bool Pandauino_Freq_LF_VHF::isSettled() {
+	return settled;
 }
 
 //*********************************************************************************************************
 // Calibrate
 // Used to calibrate the device against a frequency source with a voltage between 1V and 5V and a precision better than 1 ppm
+// Starts the calibration that is then run by freqCount() until a measure is done or calibrationTimeout is reached
+// The calibration value is the one of the board, common to all the bands: the band correction of the path measured is taken off
 void Pandauino_Freq_LF_VHF::calibrate(long calFrequency) {
 
-  double calib;
-  byte i = 0;
-  countLF = 0;
-  countHF = 0;
-
-	printSixteenCharToLCD(calibrating);
-
-  previousMode = mode;
-  previousBand = band;
-	previousResolution = resolution;
+	calibratingAll = false;
+	beginCalibration(calFrequency);
 
   determineBand(calFrequency);
-  resolution = resolution_high;
-  configureComputation(true);
+	startCalibration();
 
-	if (algorithm == algorithm_freqCount) {
+}
 
-	  // first measure is wrong so we skip it.
-	  while (!FreqCount.available()) {}
-	  while (!FreqCount.available()) {}
+//*********************************************************************************************************
+// calibrateAll
+// Calibrates every measurement path whose band includes calFrequency, one after the other.
+// Each one gets a correction relative to the calibration of the board, applied when measuring in its band.
+// A 4 MHz source calibrates HF and VHF1, a 1 KHz one LF. Other paths keep their correction.
+void Pandauino_Freq_LF_VHF::calibrateAll(long calFrequency) {
+
+	calibrationBands = 0;
+	for (byte i = band_LF; i <= band_VHF2; i++) {
+		if ((boardVersion == board_version_hf) && (i > band_HF)) break;
+		if (frequencyInBand(calFrequency, (measurementBand)i, 0)) calibrationBands |= 1 << i;
+	}
+	if (calibrationBands == 0) return;
 
-	  countHF = FreqCount.read();
-	  frequency = countHF * prescalerCoef;
-  	FreqCount.end();
+	calibratingAll = true;
+	beginCalibration(calFrequency);
+	nextCalibrationBand();
 
-	} else {
+}
 
-    while (!FreqMeasure.available()) {}
+// ************************************************************************************************************************************
+// getBandCalibration
+// Calibration factor applied when measuring in band: the board one with the correction of the path
+double Pandauino_Freq_LF_VHF::getBandCalibration(measurementBand _band) {
+  return calibration + bandCalibrationPpb[_band] / 1000000000.0;
+}
 
- 		countLF = FreqMeasure.read();
-		frequency = FreqMeasure.countToFrequency(countLF) * prescalerCoef;
-  	FreqMeasure.end();
-	}
+//*********************************************************************************************************
+// beginCalibration
+// Keeps the parameters set back by endCalibration()
+void Pandauino_Freq_LF_VHF::beginCalibration(long calFrequency) {
 
-  calib = calFrequency / frequency;
+  countLF = 0;
+  countHF = 0;
 
-	// DEBUG
-	// Serial.println(frequency,8);
+	printSixteenCharToLCD(calibrating);
 
-  if ((calib < 0.99998) || (calib > 1.00002)) {
+  previousMode = mode;
+  previousBand = band;
+	previousResolution = resolution;
+	previousGating = gating;
+	previousEstimator = estimator;
 
-		printSixteenCharToLCD(calNotPrecise);
-    delay(5000);
-    return;
-  }
+	calibrationFrequency = calFrequency;
+	reciprocalEstimate = 0.0;				// calibration uses gated counting
+	LFEstimate = calFrequency;			// and the LF periods of the calibration frequency
 
-  calibration = calib;
-  EEPROM.put(addressOfCalibration, calibration);
+}
 
-  dtostrf(calibration, 8, 7, text1);
+//*********************************************************************************************************
+// nextCalibrationBand
+// Starts the calibration of the next band of calibrationBands. Returns false when all are done
+bool Pandauino_Freq_LF_VHF::nextCalibrationBand() {
+
+	for (byte i = band_LF; i <= band_VHF2; i++) {
+		if (calibrationBands & (1 << i)) {
+			calibrationBands &= ~(1 << i);
+			band = (measurementBand)i;
+			startCalibration();
+			return true;
+		}
+	}
+	return false;
 
-	text = "Cal: ";
+}
 
-  text.concat((String)text1);
+//*********************************************************************************************************
+// startCalibration
+// Starts the calibration measure in the current band. It is then run by calibrationStep()
+void Pandauino_Freq_LF_VHF::startCalibration() {
 
-  text.toCharArray(line1, 16);  // reconvertir en char[17]
-	printSixteenCharToLCD(line1);
+  resolution = resolution_high;
+  gating = gate_fixed;				// calibrationStep() reads one full gate
+  estimator = estimator_mean;		// and one LF capture of all the periods
+  configureComputation(true);
 
-  delay(2000);
+	if (algorithm == algorithm_freqCount) {
+	  // first measure is wrong so we skip it.
+		state = state_calibration_skip;
+		calibrationTimeout = 3 * effectiveHFMeasurePeriod + 100;
+	} else {
+		state = state_calibration_gate;
+		calibrationTimeout = LFTimeout;
+	}
 
-	// set back to original parameters. ConfigureComputation is not called. It will be when leaving the menu.
-  mode = previousMode;
-  band = previousBand;
-	resolution = previousResolution;
+	stateStamp = millis();
 
 }
 
-
 /* ************************************************************************************************************************************
   MEASUREMENT FUNCTIONS
 **************************************************************************************************************************************/
@@ -801,21 +1065,24 @@ void Pandauino_Freq_LF_VHF::calibrate(long calFrequency) {
 // configureComputation
 // set up the board (prescaler path), compute prescaler and  measurement period
 // and starts the appropriate algorithm depending on measurement parameters
-void Pandauino_Freq_LF_VHF::configureComputation(bool restart = false) {
+void Pandauino_Freq_LF_VHF::configureComputation(bool restart) {
 
 	// DEBUG
 	// Serial.println("ConfigureComputation");
 
 	algorithmType previousAlgorithm = algorithm;
 
+	// Any new configuration ends the auto mode band tracking and the current band search. The search sets them again.
+	bandLocked = false;
+	state = state_measure;
+
 	pinMode(select1, OUTPUT);
 	pinMode(select2, OUTPUT);
 
 	switch (band) {
 
 		case band_LF:
-			algorithm = algorithm_freqMeasure;
-			prescalerCoef =	100;
+			algorithm = algorithm_freqMeasure;			// prescalerCoef is the number of periods measured at once, see computeLFPeriods()
 			break;
 
 		case band_HF:
@@ -865,26 +1132,41 @@ void Pandauino_Freq_LF_VHF::configureComputation(bool restart = false) {
 	}
 
 	if (algorithm == algorithm_freqMeasure) {
-		prescalerCoef *= measurementTimeCoefficient;
-	  LFTimeout = (prescalerCoef / 10) * LFTimeoutNormalRes;
+		sizeLFCapture(computeLFPeriods(LFEstimate));
 	}
 
 	if (algorithm == algorithm_freqCount) {
-		prescalerCoef /= measurementTimeCoefficient;
-		effectiveHFMeasurePeriod = HFMeasurePeriodNormalRes *  measurementTimeCoefficient;
+
+		// Gate stacking always counts with the shortest gate, the resolution only selects the result displayed
+		float gateTimeCoefficient = (gating == gate_stacked) ? stackedTimeCoefficient : measurementTimeCoefficient;
+		if (gating == gate_adaptive) gateTimeCoefficient = computeAdaptiveGate(adaptiveEstimate) / HFMeasurePeriodNormalRes;
+
+		prescalerCoef /= gateTimeCoefficient;
+		effectiveHFMeasurePeriod = HFMeasurePeriodNormalRes *  gateTimeCoefficient;
+
+		// In the HF band low frequencies are measured by reciprocal counting when the input capture can follow them
+		if ((band == band_HF) && reciprocalCounting && (gating == gate_fixed) && (reciprocalEstimate > 0.0) && (reciprocalEstimate < reciprocalMaxFrequency)) {
+			algorithm = algorithm_reciprocal;
+			reciprocalPeriods = computeReciprocalPeriods(reciprocalEstimate);
+		}
 	}
 
   if ((algorithm != previousAlgorithm) || (restart == true)) {
 
-		if (previousAlgorithm == algorithm_freqMeasure) 	FreqMeasure.end();
+		if ((previousAlgorithm == algorithm_freqMeasure) || (previousAlgorithm == algorithm_reciprocal)) 	FreqMeasure.end();
 		if (previousAlgorithm == algorithm_freqCount) 	FreqCount.end();
 
+		gateStamp = 0;
+
 		// Starts the appropriate measurement method
 		if (algorithm == algorithm_freqMeasure) {
 			// DEBUG
 			// Serial.println("Starting freqMeasure");
 			// Serial.println(prescalerCoef);
 			FreqMeasure.begin(prescalerCoef);
+			captureStamp = 0;
+		} else if (algorithm == algorithm_reciprocal) {
+			FreqMeasure.begin(reciprocalPeriods);
 		} else {
 			// DEBUG
 			// Serial.println("Starting freqCount");
@@ -892,36 +1174,1622 @@ void Pandauino_Freq_LF_VHF::configureComputation(bool restart = false) {
 		}
 	} // algo != previous
 
+	configureMultipliers();
+
+}
+
+// ************************************************************************************************************************************
+// configureMultipliers
+// The measures are computed in uHz with 64 bits integers: on AVR a double is a 32 bits float that cannot hold 7 digits at 210 MHz
+// and uHz keep the resolution of the LF measures, 5 decimals of a few Hz.
+// The calibration of the board, the one of the path of the band and the constant factors of the current algorithm
+// are folded into a single multiplier here, once per configuration.
+//
+// gated counting:  f (uHz) = count * countMultiplier >> multiplierShift
+//                  countMultiplier = path prescaler * 10^9 / gate (ms) * calibration, with multiplierShift fractional bits
+// input capture:   f (uHz) = periodNumerator / ticks
+//                  periodNumerator = F_CPU * 10^6 * periods measured at once * calibration
+void Pandauino_Freq_LF_VHF::configureMultipliers() {
+
+	byte pathPrescaler = 1;
+	unsigned long gateMs;
+	unsigned long periods;
+
+	calibrationPpb = lround((calibration - 1.0) * 1000000000.0) + bandCalibrationPpb[band];
+
+	if (algorithm == algorithm_freqCount) {
+
+		if (band == band_VHF1) pathPrescaler = coefVHF1;
+		if (band == band_VHF2) pathPrescaler = coefVHF2;
+		gateMs = lround(effectiveHFMeasurePeriod);
+
+		countMultiplier = applyCalibration(((int64_t)pathPrescaler * 1000000000 << multiplierShift) / gateMs);
+
+	} else {
+
+		if (algorithm == algorithm_reciprocal) periods = reciprocalPeriods;
+		else periods = lround(prescalerCoef);
+
+		periodNumerator = applyCalibration((int64_t)F_CPU * 1000000 * periods);
+	}
+
+}
+
+// ************************************************************************************************************************************
+// applyCalibration
+// value * calibration, computed in two parts so that the product does not overflow
+int64_t Pandauino_Freq_LF_VHF::applyCalibration(int64_t value) {
+
+	return value + (value / 1000000) * calibrationPpb / 1000 + (value % 1000000) * calibrationPpb / 1000000000;
+
+}
+
+// ************************************************************************************************************************************
+// measureLF
+// Measure using freqMeasure
+// All the captures waiting in the FreqMeasure buffer are read at once and give one measure: their periods over their clock ticks.
+// The captures are contiguous, so the time elapsed between two reads not covered by the captures read
+// is the time of the captures lost when the buffer was full. It is counted in capturesLost.
+int64_t Pandauino_Freq_LF_VHF::measureLF() {
+
+	int64_t freq = 0;
+	int64_t windowFreq;
+	unsigned int periods;
+	unsigned int currentPeriods;
+	byte captures = FreqMeasure.available();
+	byte count = 0;
+	unsigned long lost = capturesLost;
+	unsigned long now;
+	unsigned long captureTime;
+	unsigned long ticks;
+
+	if (captures == 0) return freq;
+
+	now = micros();
+	countLF = 0;
+	for (byte i = 0; i < captures; i++) {
+		ticks = FreqMeasure.read();
+		if (ticks == 0) continue;
+		countLF += ticks;
+		count++;
+		if (estimator == estimator_regression) {
+			windowFreq = regressionStep(ticks);
+			if (windowFreq > 0) freq = windowFreq;
+		}
+	}
+	if (count == 0) return freq;
+
+	if (captures > captureBacklog) captureBacklog = captures;
+
+	// Without loss the slack stays within one capture time. The first read after a restart sets the reference
+	captureTime = countLF / count;
+	// in 64 bits as the ticks of a gap of more than 134 s overflow a long
+	if (captureStamp != 0) {
+		int64_t slack = captureSlack + (int64_t)(now - captureStamp) * (F_CPU / 1000000L) - (int64_t)countLF;
+		if ((captureTime > 0) && (slack >= (int64_t)captureTime)) {
+			capturesLost += slack / captureTime;
+			slack %= captureTime;
+		}
+		captureSlack = (long)slack;
+	} else {
+		captureSlack = 0;
+	}
+	captureStamp = now;
+
+	if (estimator == estimator_regression) {
+		// The captures read are contiguous but the next ones may follow lost ones: the window starts again after them
+		if ((capturesLost != lost) || (captures >= captureBufferCapacity)) resetRegression();
+		if (freq == 0) return freq;
+	} else {
+		// periodNumerator is for one capture
+		freq = (periodNumerator * count + countLF / 2) / countLF;
+		rawCount = countLF;
+		gateTime = countLF / (F_CPU / 1000000L);
+	}
+
+	// The number of periods measured at once follows the frequency so that a measure always lasts about the same time.
+	// A measure of less than half the periods needed lacks digits: it only sizes the next ones
+	LFEstimate = freq / 1000000.0;
+	periods = computeLFPeriods(LFEstimate);
+	currentPeriods = lround(prescalerCoef) * regressionCaptures;
+
+	if ((periods > 2 * currentPeriods) || (2 * periods < currentPeriods)) {
+
+		sizeLFCapture(periods);
+		configureMultipliers();
+		FreqMeasure.end();
+		FreqMeasure.begin(prescalerCoef);
+		captureStamp = 0;
+
+		if (periods > 2 * currentPeriods) freq = 0;
+	}
+
+	return freq;
+
+}
+
+// ************************************************************************************************************************************
+// regressionStep
+// Linear regression (least squares) estimator of the LF frequency. A window of regressionCaptures captures has regressionCaptures + 1 edges:
+// edge x = 0...n-1 is at y ticks after the first one. The slope of the line fitted through them is the time of a capture,
+// with about sqrt(n / 6) times the resolution of the first and last edges alone.
+// Only the sums of y and x * y are kept, the sums of x and x^2 being known:
+//
+//   slope = 12 * sum((x - (n - 1) / 2) * y) / ((n - 1) * n * (n + 1)) = 6 * (2 * sumXY - (n - 1) * sumY) / ((n - 1) * n * (n + 1))
+//
+// Adds a capture to the window. Returns the frequency (uHz) when the window is complete, 0 otherwise.
+// The last edge of a window is the first one of the next.
+int64_t Pandauino_Freq_LF_VHF::regressionStep(unsigned long ticks) {
+
+	int64_t n;
+	int64_t slope;
+	int64_t freq;
+
+	regressionIndex++;
+	regressionTime += ticks;
+	regressionSumY += regressionTime;
+	regressionSumXY += (int64_t)regressionIndex * regressionTime;
+
+	if (regressionIndex < regressionCaptures) return 0;
+
+	// ticks per capture with regressionShift fractional bits. The window has regressionCaptures + 1 edges
+	n = regressionCaptures;
+	slope = ((6 * (2 * regressionSumXY - n * regressionSumY)) << regressionShift) / (n * (n + 1) * (n + 2));
+
+	rawCount = regressionTime;
+	gateTime = regressionTime / (F_CPU / 1000000L);
+	resetRegression();
+
+	if (slope <= 0) return 0;
+
+	// periodNumerator / slope in two parts so that the shift does not overflow
+	freq = ((periodNumerator / slope) << regressionShift) + (((periodNumerator % slope) << regressionShift) + slope / 2) / slope;
+
+	return freq;
+
+}
+
+void Pandauino_Freq_LF_VHF::resetRegression() {
+	regressionIndex = 0;
+	regressionTime = 0;
+	regressionSumY = 0;
+	regressionSumXY = 0;
+}
+
+// ************************************************************************************************************************************
+// measureHF
+// Measure using freqCount
+int64_t Pandauino_Freq_LF_VHF::measureHF_VHF() {
+
+	int64_t freq = 0;
+
+	if (algorithm == algorithm_reciprocal) return measureReciprocal();
+
+	if (FreqCount.available()) {
+		rawCount = FreqCount.read();
+		gateTime = effectiveHFMeasurePeriod * 1000;
+		freq = (rawCount * countMultiplier + (1LL << (multiplierShift - 1))) >> multiplierShift;
+
+		// FreqCount latches the free running counter at each gate end so consecutive gates are contiguous,
+		// unless a gate is read later than the end of the next one
+		if (gateStamp != 0) {
+			unsigned long gates = (millis() - gateStamp + effectiveHFMeasurePeriod / 2) / effectiveHFMeasurePeriod;
+			if (gates > 1) {
+				gatesLost += gates - 1;
+				resetStack();
+#ifdef FREQ_ENABLE_ADEV
+				resetAllan();
+#endif
+			}
+		} else {
+			resetStack();			// the counter was restarted
+#ifdef FREQ_ENABLE_ADEV
+			resetAllan();
+#endif
+		}
+		gateStamp = millis();
+
+#ifdef FREQ_ENABLE_ADEV
+		if (freq > 0) allanSample(freq);
+#endif
+
+		// The adaptive gate follows the frequency. It is restarted when too short for the digits or more than twice too long
+		if ((gating == gate_adaptive) && (freq > 0)) {
+			adaptiveEstimate = freq / 1000000.0;
+			float gate = computeAdaptiveGate(adaptiveEstimate);
+			if ((gate > effectiveHFMeasurePeriod) || (2 * gate < effectiveHFMeasurePeriod)) {
+				prescalerCoef *= effectiveHFMeasurePeriod / gate;
+				effectiveHFMeasurePeriod = gate;
+				switchHFAlgorithm(algorithm_freqCount);
+			}
+		}
+
+		// Low HF frequencies go on with reciprocal counting
+		if ((band == band_HF) && reciprocalCounting && (gating == gate_fixed) && (freq > 0) && (freq < reciprocalMaxFrequency * 1000000)) {
+			reciprocalEstimate = freq / 1000000.0;
+			switchHFAlgorithm(algorithm_reciprocal);
+		}
+	}
+
+	return freq;
+}
+
+// ************************************************************************************************************************************
+// measureReciprocal
+// Measure using the input capture: the time between the first and the last edge of reciprocalPeriods periods
+// is counted with the 16 MHz timebase, so the resolution only depends on the gate time
+int64_t Pandauino_Freq_LF_VHF::measureReciprocal() {
+
+	int64_t freq = 0;
+	unsigned int periods;
+
+	if (FreqMeasure.available()) {
+
+		countHF = FreqMeasure.read();
+		if (countHF == 0) return freq;
+
+		freq = (periodNumerator + countHF / 2) / countHF;
+		reciprocalEstimate = freq / 1000000.0;
+		rawCount = countHF;
+		gateTime = countHF / (F_CPU / 1000000L);
+
+		if (reciprocalEstimate > reciprocalMaxFrequency * ((100 + bandHysteresisPerCent) / 100)) {
+
+			// Too fast for the input capture: goes back to gated counting
+			switchHFAlgorithm(algorithm_freqCount);
+
+		} else {
+
+			// Keeps the span of the periods close to the gate time
+			periods = computeReciprocalPeriods(reciprocalEstimate);
+			if ((periods > 2 * reciprocalPeriods) || (2 * periods < reciprocalPeriods)) {
+				reciprocalPeriods = periods;
+				switchHFAlgorithm(algorithm_reciprocal);
+			}
+		}
+	}
+
+	return freq;
+}
+
+// ************************************************************************************************************************************
+// computeReciprocalPeriods
+// Number of periods of a given frequency whose span is the reciprocal gate time
+unsigned int Pandauino_Freq_LF_VHF::computeReciprocalPeriods(double freq) {
+
+	double periods = freq * effectiveHFMeasurePeriod / (reciprocalGateDivider * 1000.0);
+
+	if (periods < 1.0) return 1;
+	if (periods > reciprocalMaxPeriods) return reciprocalMaxPeriods;
+	return (unsigned int)periods;
+
+}
+
+// ************************************************************************************************************************************
+// computeLFPeriods
+// Number of periods of a given LF frequency (Hz) spanning LFMeasurePeriodNormalRes * measurementTimeCoefficient,
+// i.e. about 10^displayPrecision ticks of the 16 MHz timebase. A single period when the frequency is unknown
+unsigned int Pandauino_Freq_LF_VHF::computeLFPeriods(double freq) {
+
+	double periods = freq * LFMeasurePeriodNormalRes * measurementTimeCoefficient / 1000.0;
+
+	if (periods < 1.0) return 1;
+	if (periods > LFMaxPeriods) return LFMaxPeriods;
+	return lround(periods);
+
+}
+
+// ************************************************************************************************************************************
+// sizeLFCapture
+// Sets the periods of a capture (prescalerCoef) and the captures of a measure (regressionCaptures) for a measure of the given periods.
+// The mean estimator measures them in one capture. The regression one splits them in captures of at least regressionCaptureTime,
+// at most regressionMaxCaptures of them.
+void Pandauino_Freq_LF_VHF::sizeLFCapture(unsigned int periods) {
+
+	unsigned long capturePeriods;
+
+	prescalerCoef = periods;
+	regressionCaptures = 1;
+
+	if (estimator == estimator_regression) {
+		capturePeriods = lround(LFEstimate * regressionCaptureTime / 1000.0);
+		if (capturePeriods * regressionMaxCaptures < periods) capturePeriods = (periods + regressionMaxCaptures - 1) / regressionMaxCaptures;
+		if (capturePeriods < 1) capturePeriods = 1;
+		if (capturePeriods > periods) capturePeriods = periods;
+		prescalerCoef = capturePeriods;
+		regressionCaptures = periods / capturePeriods;
+	}
+
+	LFTimeout = computeLFTimeout();
+	resetRegression();
+
+}
+
+// ************************************************************************************************************************************
+// computeLFTimeout
+// Time of the periods of a measure at half LFEstimate, or at freqLFmin when unknown, plus LFTimeoutMargin
+unsigned long Pandauino_Freq_LF_VHF::computeLFTimeout() {
+
+	double rate = (LFEstimate > 0.0) ? LFEstimate / 2 : freqLFmin;
+	double timeout = prescalerCoef * regressionCaptures * 1000.0 / rate + LFTimeoutMargin;
+
+	if (timeout > LFTimeoutMax) return LFTimeoutMax;
+	return (unsigned long)timeout;
+
+}
+
+// ************************************************************************************************************************************
+// computeAdaptiveGate
+// Shortest gate (ms) counting 10^displayPrecision edges of a given frequency (Hz) after the prescaler of the band path,
+// i.e. giving the digits of the resolution, plus adaptiveGateMargin and within adaptiveGateMin / adaptiveGateMax.
+// The gate of the resolution when the frequency is unknown.
+float Pandauino_Freq_LF_VHF::computeAdaptiveGate(double freq) {
+
+	byte pathPrescaler = 1;
+	double gate;
+
+	if (freq <= 0.0) return HFMeasurePeriodNormalRes * measurementTimeCoefficient;
+
+	if (band == band_VHF1) pathPrescaler = coefVHF1;
+	if (band == band_VHF2) pathPrescaler = coefVHF2;
+
+	gate = ceil(pow(10, displayPrecision) * pathPrescaler * adaptiveGateMargin * 1000.0 / freq);
+
+	if (gate < adaptiveGateMin) return adaptiveGateMin;
+	if (gate > adaptiveGateMax) return adaptiveGateMax;
+	return gate;
+
+}
+
+// ************************************************************************************************************************************
+// switchHFAlgorithm
+// Restarts the HF band measurement with gated or reciprocal counting without changing the band configuration
+void Pandauino_Freq_LF_VHF::switchHFAlgorithm(algorithmType newAlgorithm) {
+
+	if (algorithm == algorithm_reciprocal) FreqMeasure.end();
+	if (algorithm == algorithm_freqCount) FreqCount.end();
+
+	algorithm = newAlgorithm;
+	gateStamp = 0;
+	configureMultipliers();
+
+	if (algorithm == algorithm_reciprocal) FreqMeasure.begin(reciprocalPeriods);
+	else FreqCount.begin(effectiveHFMeasurePeriod);
+
+}
+
+// ************************************************************************************************************************************
+//  setContinuousGating
+// When enabled the HF / VHF counting is not restarted by the periodic Vcc test nor by the auto mode band re-verification
+// so that, in mode_band or in auto mode with band tracking, every input cycle falls in a gate
+void Pandauino_Freq_LF_VHF::setContinuousGating(bool _continuousGating) {
+  continuousGating = _continuousGating;
+}
+
+// Number of gates lost since the start, i.e. overwritten by the next one before freqCount() could read them
+unsigned long Pandauino_Freq_LF_VHF::getGatesLost() {
+  return gatesLost;
+}
+
+// Number of LF captures lost since the start as the FreqMeasure buffer was full, i.e. freqCount() was not called often enough
+unsigned long Pandauino_Freq_LF_VHF::getCapturesLost() {
+  return capturesLost;
+}
+
+// Largest number of LF captures read at once by freqCount(). Close to the FreqMeasure buffer size (11), captures are about to be lost
+byte Pandauino_Freq_LF_VHF::getCaptureBacklog() {
+  return captureBacklog;
+}
+
+// ************************************************************************************************************************************
+//  setGateMode
+// gate_stacked runs the HF / VHF gated counting on 10 ms gates and derives the low, normal, high and ultra high resolution results
+// from them at the same time, see stackGate(). The resolution setting then only selects the result displayed.
+// Reciprocal counting is not used in this mode.
+// gate_adaptive sets the gate to the shortest one giving the digits of the resolution at the frequency last measured,
+// e.g. 176 ms instead of 1 s in high resolution at 200 MHz on the /32 path, see computeAdaptiveGate(). Reciprocal counting is not used either.
+void Pandauino_Freq_LF_VHF::setGateMode(gateMode _gating) {
+  gating = _gating;
+  resetStack();
+  if ((state == state_measure) && (band != band_LF)) configureComputation(true);
+}
+
+// ************************************************************************************************************************************
+//  setStackPublish
+// With gate stacking only the result of the resolution is published to the ring buffer, the binary frames and I2C by default.
+// levels adds others, bit 1 << resolution, e.g. (1 << resolution_high) | (1 << resolution_ultra_high) for the 1 s and 10 s results.
+// The 10 ms results come 100 times a second: the ring buffer only keeps them when it is drained as often.
+void Pandauino_Freq_LF_VHF::setStackPublish(byte levels) {
+  stackPublished = levels;
+}
+
+// ************************************************************************************************************************************
+//  setLFEstimator
+// estimator_mean measures the LF frequency from the first and last edges of the periods of a measure.
+// estimator_regression captures them in short parts and fits a line through the times of all their edges, see regressionStep().
+// It needs freqCount() to be called at least every 20 ms.
+void Pandauino_Freq_LF_VHF::setLFEstimator(estimatorType _estimator) {
+  estimator = _estimator;
+  if ((state == state_measure) && (band == band_LF)) configureComputation(true);
+}
+
+// ************************************************************************************************************************************
+//  setFilter
+// Filters applied to the measures of a band before they are published and displayed, in this order:
+// glitchPpm:  a measure further than glitchPpm from the last value displayed is rejected, up to filterGlitchRejects in a row. 0 = off
+// median:     running median of the last median measures, 1 = off, at most FILTER_MEDIAN_SIZE
+// emaAlpha:   exponential moving average, the weight of a new measure in 1/256. 0 = off
+// e.g. setFilter(band_VHF2, 3, 64, 100) rejects single bad gates of a noisy RF pickup and smooths the result.
+void Pandauino_Freq_LF_VHF::setFilter(measurementBand _band, byte median, byte emaAlpha, unsigned long glitchPpm) {
+  if (median < 1) median = 1;
+  if (median > FILTER_MEDIAN_SIZE) median = FILTER_MEDIAN_SIZE;
+  bandFilter[_band].median = median;
+  bandFilter[_band].emaAlpha = emaAlpha;
+  bandFilter[_band].glitchPpm = glitchPpm;
+  resetFilter();
+}
+
+// Number of measures rejected as glitches since the start
+unsigned long Pandauino_Freq_LF_VHF::getFilterRejects() {
+  return filterRejects;
+}
+
+// ************************************************************************************************************************************
+//  resetStatistics / getStatistics
+// Running statistics of the measures displayed, after the filters, since resetStatistics() or the last settings change.
+// They are kept in a few integers whatever the number of measures, so there is no need to stream them all to get a summary.
+// The mean and the standard deviation are given by the "Statistics" menu entry as well.
+void Pandauino_Freq_LF_VHF::resetStatistics() {
+  statisticsCount = 0;
+  statisticsMean = 0;
+  statisticsM2 = 0;
+  statisticsShift = 0;
+}
+
+void Pandauino_Freq_LF_VHF::getStatistics(measurementStatistics &statistics) {
+
+  statistics.count = statisticsCount;
+  statistics.minimum = (statisticsCount > 0) ? statisticsMinimum : 0;
+  statistics.maximum = (statisticsCount > 0) ? statisticsMaximum : 0;
+  statistics.mean = (statisticsMean + (1LL << (statisticsMeanShift - 1))) >> statisticsMeanShift;
+  statistics.deviation = 0;
+  if (statisticsCount > 1) statistics.deviation = (int64_t)squareRoot(statisticsM2 / (statisticsCount - 1)) << statisticsShift;
+}
+
+// Last result of a resolution given by the gate stacking. 0.0 if not available yet
+double Pandauino_Freq_LF_VHF::getStackedFrequency(measurementResolution _resolution) {
+  return stackedFrequency[_resolution] / 1000000.0;
+}
+
+// ************************************************************************************************************************************
+//  setReciprocalCounting
+// When enabled, HF band frequencies below reciprocalMaxFrequency are measured by reciprocal counting
+void Pandauino_Freq_LF_VHF::setReciprocalCounting(bool _reciprocalCounting) {
+  reciprocalCounting = _reciprocalCounting;
+  reciprocalEstimate = 0.0;
+  if ((reciprocalCounting == false) && (algorithm == algorithm_reciprocal)) switchHFAlgorithm(algorithm_freqCount);
+}
+
+//*********************************************************************************************************
+// startProbe
+// Sets the VHF2 (/32) path used by the auto mode to find the band. The short probe gate is started after prescalerSettleDelay
+void Pandauino_Freq_LF_VHF::startProbe() {
+
+	band = band_VHF2;
+
+	pinMode(select1, OUTPUT);
+	pinMode(select2, OUTPUT);
+	digitalWrite(select1,LOW);
+	digitalWrite(select2,LOW);
+
+	if ((algorithm == algorithm_freqMeasure) || (algorithm == algorithm_reciprocal)) FreqMeasure.end();
+	if (algorithm == algorithm_freqCount) FreqCount.end();
+
+	algorithm = algorithm_freqCount;
+
+}
+
+// ************************************************************************************************************************************
+// measureProbe
+// Coarse measure of the probe gate started by startProbe()
+double Pandauino_Freq_LF_VHF::measureProbe() {
+
+	double freq = 0.0;
+
+	if (FreqCount.available()) {
+		freq = FreqCount.read() * coefVHF2 * (1000.0 / HFProbePeriod) * calibration;
+	}
+
+	return freq;
+}
+
+/* ************************************************************************************************************************************
+  OUTPUT FUNCTIONS
+**************************************************************************************************************************************/
+
+//*********************************************************************************************************
+// newMeasurement
+// Every new measured value goes through here: it is published then displayed
+void Pandauino_Freq_LF_VHF::newMeasurement(int64_t freq) {
+
+	if ((gating == gate_stacked) && (algorithm == algorithm_freqCount)) {
+		stackGate();
+		return;
+	}
+
+	freq = filterMeasurement(freq);
+	if (freq == 0) return;
+
+	publishMeasurement(freq);
+	updateStatistics(freq);
+
+	frequencyMicroHertz = freq;
+	frequency = freq / 1000000.0;
+	displayMeasurement();
+
+}
+
+//*********************************************************************************************************
+// filterMeasurement
+// The filters of the band, see setFilter(): glitch rejection, running median then exponential moving average.
+// Returns the filtered measure (uHz), 0 when it is rejected. Only fixed size buffers are used.
+int64_t Pandauino_Freq_LF_VHF::filterMeasurement(int64_t freq) {
+
+	filterSettings &filter = bandFilter[band];
+	int64_t sorted[FILTER_MEDIAN_SIZE];
+	int64_t deviation;
+	int64_t value;
+	byte n;
+	byte i;
+	byte j;
+
+	if (band != filterBand) {
+		resetFilter();
+		filterBand = band;
+	}
+
+	// ******** glitch rejection against the last value displayed *****
+	// the window is split at 10^6 as in applyCalibration(), to keep its part below 1 Hz without overflow
+	if ((filter.glitchPpm > 0) && (lastValidFrequency > 0)) {
+		deviation = freq - lastValidFrequency;
+		if (deviation < 0) deviation = -deviation;
+		if (deviation > (lastValidFrequency / 1000000) * (int64_t)filter.glitchPpm + (lastValidFrequency % 1000000) * (int64_t)filter.glitchPpm / 1000000) {
+			if (glitchRejects < filterGlitchRejects) {
+				glitchRejects++;
+				filterRejects++;
+				return 0;
+			}
+			resetFilter();		// the frequency really changed, the measures in the filters are obsolete
+		}
+	}
+	glitchRejects = 0;
+
+	// ******** running median *****
+	if (filter.median > 1) {
+
+		filterHistory[filterIndex] = freq;
+		filterIndex = (filterIndex + 1) % filter.median;
+		if (filterCount < filter.median) filterCount++;
+
+		// insertion sort of the measures, at most FILTER_MEDIAN_SIZE of them
+		n = filterCount;
+		for (i = 0; i < n; i++) {
+			value = filterHistory[i];
+			for (j = i; (j > 0) && (sorted[j - 1] > value); j--) sorted[j] = sorted[j - 1];
+			sorted[j] = value;
+		}
+		freq = (n & 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+	}
+
+	// ******** exponential moving average *****
+	if (filter.emaAlpha > 0) {
+		if (filterAverage == 0) filterAverage = freq;
+		else filterAverage += (freq - filterAverage) * filter.emaAlpha / 256;
+		freq = filterAverage;
+	}
+
+	return freq;
+
+}
+
+void Pandauino_Freq_LF_VHF::resetFilter() {
+	filterCount = 0;
+	filterIndex = 0;
+	filterAverage = 0;
+	glitchRejects = 0;
+}
+
+//*********************************************************************************************************
+// updateStatistics
+// Welford's algorithm in fixed point: mean += delta / n and M2 += delta * (freq - new mean), in uHz.
+// The mean has statisticsMeanShift more bits so that the roundings of delta / n do not add up over a long run.
+// Both factors of the product are kept below 2^30 and M2 below 2^61 by raising statisticsShift, so the 64 bit M2 cannot overflow.
+// The shift only grows past 0 when the measures spread over more than 1 kHz, where the lost uHz do not matter.
+void Pandauino_Freq_LF_VHF::updateStatistics(int64_t freq) {
+
+	int64_t delta;
+	int64_t newDelta;
+
+	statisticsCount++;
+
+	if (statisticsCount == 1) {
+		statisticsMinimum = freq;
+		statisticsMaximum = freq;
+		statisticsMean = freq << statisticsMeanShift;
+		return;
+	}
+
+	if (freq < statisticsMinimum) statisticsMinimum = freq;
+	if (freq > statisticsMaximum) statisticsMaximum = freq;
+
+	delta = (freq << statisticsMeanShift) - statisticsMean;
+	if (delta >= 0) statisticsMean += (delta + (int64_t)(statisticsCount / 2)) / (int64_t)statisticsCount;
+	else statisticsMean -= (-delta + (int64_t)(statisticsCount / 2)) / (int64_t)statisticsCount;
+
+	// back to uHz. delta and newDelta have the same sign, their product is positive
+	newDelta = ((freq << statisticsMeanShift) - statisticsMean) >> statisticsMeanShift;
+	delta >>= statisticsMeanShift;
+	if (delta < 0) {
+		delta = -delta;
+		newDelta = -newDelta;
+	}
+
+	while (((delta >> statisticsShift) >= (1L << 30)) || (statisticsM2 >= (1ULL << 61))) {
+		statisticsShift++;
+		statisticsM2 >>= 2;
+	}
+
+	statisticsM2 += (uint64_t)(delta >> statisticsShift) * (uint64_t)(newDelta >> statisticsShift);
+
+}
+
+//*********************************************************************************************************
+// publishMeasurement
+// Stores the measure (rawCount, gateTime, freq) in the ring buffer and sends it as a binary frame when selected
+void Pandauino_Freq_LF_VHF::publishMeasurement(int64_t freq) {
+
+	measurementSequence++;
+
+	pushMeasurement(freq);
+
+	if (outputToSerial && (outputFormat == serial_binary)) sendBinaryFrame(freq);
+
+#ifdef FREQ_ENABLE_I2C
+	if (i2cAddress != 0) updateI2CSnapshot(true, freq);
+#endif
+
+}
+
+//*********************************************************************************************************
+// stackGate
+// Gate stacking: the 10 ms gate just read (rawCount) is summed by 10 into a 100 ms result, these by 10 into a 1 s result
+// and these by 10 into a 10 s result. FreqCount gates are contiguous so no input cycle is lost between them.
+// The result matching the resolution is published and displayed when complete, the others only published when selected by setStackPublish().
+void Pandauino_Freq_LF_VHF::stackGate() {
+
+	unsigned long count = rawCount;
+	int64_t multiplier = countMultiplier;		// divided by 10 at each level as the gate is 10 times longer
+	int64_t stackFrequency;
+	byte level = 0;
+
+	while (true) {
+
+		stackFrequency = (count * multiplier + (1LL << (multiplierShift - 1))) >> multiplierShift;
+
+		stackedFrequency[level] = stackFrequency;
+		rawCount = count;
+
+		// The result displayed goes through the filters of the band, the others are published as measured
+		if (level == resolution) {
+			stackFrequency = filterMeasurement(stackFrequency);
+			if (stackFrequency > 0) {
+				publishMeasurement(stackFrequency);
+				updateStatistics(stackFrequency);
+				frequencyMicroHertz = stackFrequency;
+				frequency = stackFrequency / 1000000.0;
+				displayMeasurement();
+			}
+		} else if (stackPublished & (1 << level)) {
+			publishMeasurement(stackFrequency);
+		}
+
+		if (level == 3) break;
+
+		// sums into the next level, which is complete after 10 gates
+		stackSum[level] += count;
+		stackGates[level]++;
+		if (stackGates[level] < 10) break;
+
+		count = stackSum[level];
+		stackSum[level] = 0;
+		stackGates[level] = 0;
+		gateTime *= 10;
+		multiplier /= 10;
+		level++;
+	}
+
+}
+
+//*********************************************************************************************************
+// resetStack
+// Restarts the gate stacking, when a gate was lost or the counter restarted
+void Pandauino_Freq_LF_VHF::resetStack() {
+
+	for (byte i = 0; i < 3; i++) {
+		stackSum[i] = 0;
+		stackGates[i] = 0;
+	}
+	for (byte i = 0; i < 4; i++) stackedFrequency[i] = 0;
+
+}
+
+//*********************************************************************************************************
+// pushMeasurement
+// Stores the last measure in the ring buffer. When it is full the measure is lost and counted in ringOverflows.
+// freqCount() is the only writer and the reader only moves ringTail so readMeasurements() may be called from an interrupt.
+void Pandauino_Freq_LF_VHF::pushMeasurement(int64_t freq) {
+
+	byte next = (ringHead + 1) & (MEASUREMENT_RING_SIZE - 1);
+
+	if (next == ringTail) {
+		ringOverflows++;
+		return;
+	}
+
+	measurementRing[ringHead].timestamp = millis();
+	measurementRing[ringHead].band = band;
+	measurementRing[ringHead].rawCount = rawCount;
+	measurementRing[ringHead].gateTime = gateTime;
+	measurementRing[ringHead].valueLow = (uint32_t)freq;
+	measurementRing[ringHead].valueHigh = (uint16_t)(freq >> 32);
+
+	asm volatile("" ::: "memory");		// the record is complete before it is published
+	ringHead = next;
+
+}
+
+//*********************************************************************************************************
+// sendBinaryFrame
+// Sends the last measure as a 26 bytes frame, little endian:
+//
+// offset size
+//  0     2   sync 0xA5 0x5A
+//  2     2   sequence number
+//  4     4   time stamp (ms)
+//  8     1   band (bits 0-3) and algorithm (bits 4-7)
+//  9     4   gate time (us)
+// 13     4   raw count: edges in gated counting, 16 MHz clock ticks in input capture
+// 17     7   calibrated frequency in uHz, signed
+// 24     2   CRC-16/CCITT-FALSE of bytes 2 to 23
+//
+// The frame is dropped rather than waiting when the serial transmit buffer is full. The sequence number shows it.
+void Pandauino_Freq_LF_VHF::sendBinaryFrame(int64_t microHertz) {
+
+	uint16_t crc = 0xFFFF;
+	byte i;
+
+	if (Serial.availableForWrite() < frameLength) return;
+
+	frame[0] = frameSync1;
+	frame[1] = frameSync2;
+	i = putBytes(frame, 2, measurementSequence, 2);
+	i = putBytes(frame, i, millis(), 4);
+	frame[i++] = band | (algorithm << 4);
+	i = putBytes(frame, i, gateTime, 4);
+	i = putBytes(frame, i, rawCount, 4);
+	i = putBytes(frame, i, (unsigned long)microHertz, 4);
+	i = putBytes(frame, i, (unsigned long)(microHertz >> 32), 3);
+
+	for (byte j = 2; j < i; j++) crc = crc16Update(crc, frame[j]);
+	putBytes(frame, i, crc, 2);
+
+	Serial.write(frame, frameLength);
+
+}
+
+//*********************************************************************************************************
+// serialPrintMicroHertz
+// Prints a frequency in uHz as Hz with 6 exact decimals
+void Pandauino_Freq_LF_VHF::serialPrintMicroHertz(int64_t value) {
+
+	unsigned long microHertz;
+
+	if (value < 0) {
+		Serial.print('-');
+		value = -value;
+	}
+	microHertz = value % 1000000;
+
+	Serial.print((unsigned long)(value / 1000000));
+	Serial.print('.');
+	for (unsigned long digit = 100000; digit > microHertz; digit /= 10) Serial.print('0');
+	if (microHertz != 0) Serial.print(microHertz);
+	Serial.println();
+
+}
+
+//*********************************************************************************************************
+// Reads nbBytes from buffer at position, little endian
+unsigned long Pandauino_Freq_LF_VHF::getBytes(const byte buffer[], byte position, byte nbBytes) {
+
+	unsigned long value = 0;
+
+	while (nbBytes > 0) value = (value << 8) | buffer[position + --nbBytes];
+	return value;
+
+}
+
+//*********************************************************************************************************
+// Writes the nbBytes low bytes of value into buffer at position, little endian, returns the next position
+byte Pandauino_Freq_LF_VHF::putBytes(byte buffer[], byte position, unsigned long value, byte nbBytes) {
+
+	for (byte i = 0; i < nbBytes; i++) {
+		buffer[position++] = (byte)value;
+		value >>= 8;
+	}
+	return position;
+
+}
+
+//*********************************************************************************************************
+// CRC-16/CCITT-FALSE, polynomial 0x1021, initial value 0xFFFF
+uint16_t Pandauino_Freq_LF_VHF::crc16Update(uint16_t crc, byte data) {
+
+	crc ^= (uint16_t)data << 8;
+	for (byte i = 0; i < 8; i++) {
+		if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+		else crc <<= 1;
+	}
+	return crc;
+
+}
+
+#ifdef FREQ_ENABLE_I2C
+//*********************************************************************************************************
+// i2cReceive
+// Wire receive interrupt: the first byte sets the register pointer, the next ones are written from there.
+// Only i2c_control is writable. It is applied later by serviceI2C() so the interrupt stays short.
+// The byte count given by Wire is not needed, Wire.available() gives it.
+void Pandauino_Freq_LF_VHF::i2cReceive(int) {
+
+	byte pointer;
+
+	if (Wire.available() == 0) return;
+
+	pointer = Wire.read();
+	i2cPointer = pointer;
+
+	while (Wire.available()) {
+		if (pointer == i2c_control) i2cControl = Wire.read();
+		else Wire.read();
+		pointer++;
+	}
+
+}
+
+//*********************************************************************************************************
+// i2cRequest
+// Wire request interrupt. The register pointer does not move so a master can poll the same registers.
+// Below i2c_fifo_data, the registers up to i2c_fifo_data are sent from the snapshot, only written by freqCount() with the interrupts off.
+// At i2c_fifo_data, the oldest measurement is removed from the FIFO and sent as 22 bytes:
+// the number of measurements waiting including this one (0 when the FIFO is empty and the rest is zeroed),
+// then time stamp (4), band (1), raw count (4), gate time (4) and frequency in uHz (8)
+void Pandauino_Freq_LF_VHF::i2cRequest() {
+
+	byte record[i2cRecordLength];
+	measurementRecord measurement = {0, 0, 0, 0, 0};
+	byte i;
+
+	if (i2cPointer < i2c_fifo_data) {
+		Wire.write(&i2cSnapshot[i2cPointer], i2c_fifo_data - i2cPointer);
+		return;
+	}
+
+	if ((i2cPointer > i2c_fifo_data) && (i2cPointer < i2c_register_end)) {
+		Wire.write(&i2cSnapshot[i2cPointer], i2c_register_end - i2cPointer);
+		return;
+	}
+
+	if (i2cPointer > i2c_fifo_data) {
+		Wire.write((byte)0);
+		return;
+	}
+
+	record[0] = measurementsAvailable();
+	readMeasurements(&measurement, 1);
+
+	i = putBytes(record, 1, measurement.timestamp, 4);
+	record[i++] = measurement.band;
+	i = putBytes(record, i, measurement.rawCount, 4);
+	i = putBytes(record, i, measurement.gateTime, 4);
+	i = putBytes(record, i, (unsigned long)measurement.value, 4);
+	putBytes(record, i, (unsigned long)(measurement.value >> 32), 4);
+
+	Wire.write(record, i2cRecordLength);
+
+}
+
+//*********************************************************************************************************
+// serviceI2C
+// Called by freqCount() in I2C slave mode: applies a control write and refreshes the snapshot when the state changed
+void Pandauino_Freq_LF_VHF::serviceI2C() {
+
+	byte control;
+	byte *snapshot = i2cSnapshot;
+	measurementMode oldMode = mode;
+	measurementBand oldBand = band;
+	measurementResolution oldResolution = resolution;
+
+	// the control write waits for the counter to be out of calibration, standby and menu
+	if ((i2cControl & i2c_control_apply) && !(i2cStatus() & (i2c_status_calibrating | i2c_status_standby | i2c_status_menu))) {
+
+		noInterrupts();
+		control = i2cControl;
+		i2cControl = 0;
+		interrupts();
+
+		// the VHF bands only exist on the VHF board
+		if ((boardVersion == board_version_vhf) || (((control >> 1) & 0x03) <= band_HF)) {
+			mode = (measurementMode)(control & 0x01);
+			band = (measurementBand)((control >> 1) & 0x03);
+			resolution = (measurementResolution)((control >> 3) & 0x03);
+			configureComputation(true);
+
+			// as a change from the menu, see actions()
+			if ((mode != oldMode) || (band != oldBand) || (resolution != oldResolution)) {
+				settingsChanged();
+				resetStatistics();
+				resetDrift();
+			}
+		}
+	}
+
+	if ((snapshot[i2c_status] != i2cStatus()) || (snapshot[i2c_band] != band) || (snapshot[i2c_algorithm] != algorithm)
+			|| (snapshot[i2c_fifo_count] != measurementsAvailable()) || (snapshot[i2c_control] != (mode | (band << 1) | (resolution << 3)))
+			|| (snapshot[i2c_gate_mode] != gating)) {
+		updateI2CSnapshot(false, 0);
+	}
+
+}
+
+//*********************************************************************************************************
+// i2cStatus
+// Status register of the I2C slave mode, i2cStatusFlag bits
+byte Pandauino_Freq_LF_VHF::i2cStatus() {
+
+	byte status = 0;
+
+	switch (state) {
+
+		case state_measure:
+		if (measurementSequence != 0) status |= i2c_status_valid;
+		break;
+
+		case state_search_probe_settle:
+		case state_search_probe:
+		case state_search_gate_settle:
+		case state_search_gate:
+		status |= i2c_status_searching;
+		break;
+
+		case state_calibration_skip:
+		case state_calibration_gate:
+		status |= i2c_status_calibrating;
+		break;
+
+		case state_standby_message:
+		case state_standby_off:
+		case state_wake_up:
+		status |= i2c_status_standby;
+		break;
+
+		case state_voltage_error:
+		status |= i2c_status_voltage_error;
+		break;
+	}
+
+	if (editMode != display_main) status |= i2c_status_menu;
+	if (ringOverflows != 0) status |= i2c_status_fifo_overflow;
+	if (i2cControl & i2c_control_apply) status |= i2c_status_control_pending;
+
+	return status;
+
+}
+
+//*********************************************************************************************************
+// updateI2CSnapshot
+// Updates the I2C registers from the current state, with the last measurement when newMeasure.
+// The values are computed first and written with the interrupts off, so that the Wire interrupt, which copies
+// the registers to its buffer on a request, never sends a half updated measurement.
+void Pandauino_Freq_LF_VHF::updateI2CSnapshot(bool newMeasure, int64_t freq) {
+
+	byte status = i2cStatus();
+	byte fifoCount = measurementsAvailable();
+	unsigned long stamp = millis();
+	unsigned long drift;
+
+	if (driftRate > 2147483647LL) drift = 2147483647UL;
+	else if (driftRate < -2147483647LL) drift = (unsigned long)-2147483647L;
+	else drift = (unsigned long)driftRate;
+
+	noInterrupts();
+
+	i2cSnapshot[i2c_status] = status;
+	i2cSnapshot[i2c_mode] = mode;
+	i2cSnapshot[i2c_band] = band;
+	i2cSnapshot[i2c_resolution] = resolution;
+	i2cSnapshot[i2c_algorithm] = algorithm;
+	i2cSnapshot[i2c_gate_mode] = gating;
+
+	if (newMeasure) {
+		putBytes(i2cSnapshot, i2c_sequence, measurementSequence, 2);
+		putBytes(i2cSnapshot, i2c_frequency, (unsigned long)freq, 4);
+		putBytes(i2cSnapshot, i2c_frequency + 4, (unsigned long)(freq >> 32), 4);
+		putBytes(i2cSnapshot, i2c_timestamp, stamp, 4);
+		putBytes(i2cSnapshot, i2c_gate_time, gateTime, 4);
+		putBytes(i2cSnapshot, i2c_raw_count, rawCount, 4);
+	}
+
+	putBytes(i2cSnapshot, i2c_overflows, ringOverflows, 4);
+	i2cSnapshot[i2c_fifo_count] = fifoCount;
+	i2cSnapshot[i2c_control] = mode | (band << 1) | (resolution << 3);
+
+#ifdef FREQ_ENABLE_ADEV
+	putBytes(i2cSnapshot, i2c_adev_gate, allanGateTime, 4);
+	putBytes(i2cSnapshot, i2c_adev_samples, allanCount, 4);
+	for (byte octave = 0; octave < ALLAN_OCTAVES; octave++) putBytes(i2cSnapshot, i2c_adev + 4 * octave, allanValue[octave], 4);
+#endif
+
+	putBytes(i2cSnapshot, i2c_drift, drift, 4);
+	i2cSnapshot[i2c_settled] = settled;
+
+	interrupts();
+
+}
+#endif
+
+/* ************************************************************************************************************************************
+  STATE MACHINE FUNCTIONS
+**************************************************************************************************************************************/
+
+//*********************************************************************************************************
+// searchStep
+// One step of the auto mode band search: a short probe gate on the /32 path, then a full resolution gate on the band found
+void Pandauino_Freq_LF_VHF::searchStep() {
+
+	switch (state) {
+
+		case state_measure:	// starts a new search
+
+			frequencyTestVHF2 = 0.0;
+			frequencyTest = 0;
+
+			// Probing only for the VHF board version. The HF board has a single HF path.
+			if (boardVersion == board_version_vhf) {
+				startProbe();
+				state = state_search_probe_settle;
+			} else {
+				band = band_HF;
+				configureComputation(true);
+				state = state_search_gate_settle;
+			}
+			stateStamp = millis();
+			break;
+
+		case state_search_probe_settle:	// to clear the prescaler buffering effect
+
+			if ((millis() - stateStamp) > prescalerSettleDelay) {
+				FreqCount.begin(HFProbePeriod);
+				state = state_search_probe;
+				measureStamp = millis();
+			}
+			break;
+
+		case state_search_probe:
+
+	  	// Here we determine the effective band with one short probe gate on the /32 path
+	  	// which covers the whole HF / VHF range with a coarse resolution.
+			frequencyTestVHF2 = measureProbe();
+
+			if ((frequencyTestVHF2 > 0.0) || ((millis() - measureStamp) > (HFProbePeriod + 30))) {
+
+				// Below the VHF1 band the /32 count is too coarse: the HF path decides between HF and LF
+				// and the adaptive gate starts from the gate of the resolution
+				if (frequencyTestVHF2 >= freqVHF1min) { determineBand(frequencyTestVHF2); adaptiveEstimate = frequencyTestVHF2; }
+				else { band = band_HF; adaptiveEstimate = 0.0; }
+
+				configureComputation(true);
+				state = state_search_gate_settle;
+				stateStamp = millis();
+			}
+			break;
+
+		case state_search_gate_settle:	// to clear the prescaler buffering effect
+
+			if ((millis() - stateStamp) > prescalerSettleDelay) {
+				state = state_search_gate;
+				measureStamp = millis();
+			}
+			break;
+
+		case state_search_gate:
+
+			// Full resolution measurement in the band found
+			frequencyTest = measureHF_VHF();
+
+			if ((frequencyTest > 0) || ((millis() - measureStamp) > (effectiveHFMeasurePeriod + 30))) {
+
+				state = state_measure;
+
+				// if frequency zero or in the LF range switch to LF computing.
+				if (frequencyTest < freqLFmax * 1000000) {
+
+					band = band_LF;
+					LFEstimate = 0.0;		// sized by the first period
+					configureComputation(true);
+					measureStamp = millis(); // false measureStamp to let LF measurement run
+
+				} else {
+
+					// keeps the band for the next measurements
+					bandLocked = bandTracking;
+					bandLockStamp = millis();
+					measureStamp = millis();
+
+					// displays the final value
+					newMeasurement(frequencyTest);
+
+				} 	// switch to LF or not
+			}
+			break;
+
+		default:
+			break;
+	}
+
+}
+
+//*********************************************************************************************************
+// calibrationStep
+// Waits for the calibration measure started by calibrate() and computes the calibration value
+void Pandauino_Freq_LF_VHF::calibrationStep() {
+
+  double calib;
+  byte position;
+
+	if ((millis() - stateStamp) > calibrationTimeout) {
+		stopComputation();
+		printSixteenCharToLCD(const_cast<char*>(noMeasureAvailable));
+		holdMessage(5000);
+		if (calibratingAll && nextCalibrationBand()) return;
+		endCalibration();
+		return;
+	}
+
+	if (algorithm == algorithm_freqCount) {
+
+		if (!FreqCount.available()) return;
+
+		if (state == state_calibration_skip) {
+			FreqCount.read();
+			state = state_calibration_gate;
+			return;
+		}
+
+	  countHF = FreqCount.read();
+	  frequency = countHF * prescalerCoef;
+  	FreqCount.end();
+
+	} else {
+
+    if (!FreqMeasure.available()) return;
+
+ 		countLF = FreqMeasure.read();
+		frequency = FreqMeasure.countToFrequency(countLF) * prescalerCoef;
+  	FreqMeasure.end();
+	}
+
+  calib = calibrationFrequency / frequency;
+
+	// DEBUG
+	// Serial.println(frequency,8);
+
+  if ((calib < 0.99998) || (calib > 1.00002)) {
+
+		printSixteenCharToLCD(calNotPrecise);
+		holdMessage(5000);
+
+  } else if (calibratingAll) {
+
+		bandCalibrationPpb[band] = lround((calib - calibration) * 1000000000.0);
+	  settingsChanged();
+
+  } else {
+
+	  calibration = calib - bandCalibrationPpb[band] / 1000000000.0;
+	  settingsChanged();
+
+	  position = appendText(0, "Cal: ");
+	  position = appendFixed(position, 10000000 + lround((calibration - 1.0) * 10000000.0), 7);
+	  endLine(position);
+		printSixteenCharToLCD(line1);
+		holdMessage(2000);
+	}
+
+	if (calibratingAll && nextCalibrationBand()) return;
+	endCalibration();
+
+}
+
+//*********************************************************************************************************
+// endCalibration
+// sets back the original parameters. When called from the menu configureComputation is not called. It will be when leaving the menu.
+// They are stored again, the journal may have saved the calibration setup meanwhile.
+void Pandauino_Freq_LF_VHF::endCalibration() {
+
+  mode = previousMode;
+  band = previousBand;
+	resolution = previousResolution;
+	gating = previousGating;
+	estimator = previousEstimator;
+	settingsChanged();
+
+	state = state_measure;
+
+	if (editMode == display_main) {
+		configureComputation(true);
+		measureStamp = millis();
+	}
+	else printMenuEntry();		// after the message held, if any
+
+}
+
+//*********************************************************************************************************
+// standbyStep
+// Runs the standby sequence started by standbyMode(): message, power off, sleep then wake up
+void Pandauino_Freq_LF_VHF::standbyStep() {
+
+	switch (state) {
+
+		case state_standby_message:
+
+			if ((millis() - stateStamp) > standbyMessageTime) {
+
+			  // Turn off LCD display
+			  lcd.noDisplay();
+
+			  // Turn off power to LCD and 6.7V regulator
+			  digitalWrite(lcdLedPowerPin, LOW);          // lcd power cut
+			  digitalWrite(VccReg65EnablePin, LOW);       // 6.5V regulator disabled
+
+				state = state_standby_off;
+				stateStamp = millis();
+			}
+			break;
+
+		case state_standby_off:
+
+			if ((millis() - stateStamp) > standbyPowerOffTime) {
+
+			  attachInterrupt(digitalPinToInterrupt(PUSHBUTTON), pushButtonInterrupt, LOW);    // attaches an interrupt on PUSHBUTTON pin
+
+			  // put to sleep
+			  halPowerDown();
+
+			  // ****************
+			  // wake up here
+			  detachInterrupt(digitalPinToInterrupt(PUSHBUTTON)); // avoid continuous firing
+
+			  // frequency re-initialized
+			  frequency = 0;
+			  frequencyMicroHertz = 0;
+
+			  digitalWrite(lcdLedPowerPin, HIGH);          // lcd power on
+			  digitalWrite(VccReg65EnablePin, HIGH);       // 6.5V regulator enabled
+
+			  lcd.display();
+			  invalidateLCDShadow();							// the content may have been lost with the power
+
+				// Let the amplifier circuit charge.
+				state = state_wake_up;
+				stateStamp = millis();
+			}
+			break;
+
+		case state_wake_up:
+
+			if ((millis() - stateStamp) > wakeUpTime) {
+				state = state_measure;
+			  measureStamp = millis();                // false measureStamp to avoid falling into sleep again
+			}
+			break;
+
+		default:
+			break;
+	}
+
+}
+
+/* ************************************************************************************************************************************
+  TIMEBASE DISCIPLINING FUNCTIONS
+**************************************************************************************************************************************/
+
+//*********************************************************************************************************
+// ppsInterrupt
+// Called by the HAL on each 1 PPS rising edge with the micros() of the edge
+void Pandauino_Freq_LF_VHF::ppsInterrupt(unsigned long stamp) {
+	ppsStamp = stamp;
+	ppsCount++;
+}
+
+//*********************************************************************************************************
+// disciplineStep
+// The pulses are grouped in blocks of ppsBlockLength seconds. The MCU time of a block against its whole number of true seconds
+// gives one measure of the timebase error, the resolution of micros() (4 us) and the jitter of the pulses being spread over the block.
+// A block ends on the first pulse of the next one so the time tagging errors do not add up.
+// A missed pulse or an interval off by more than ppsTolerance restarts the block.
+void Pandauino_Freq_LF_VHF::disciplineStep() {
+
+	if (discipline == discipline_off) return;
+
+	noInterrupts();
+	byte count = ppsCount;
+	unsigned long stamp = ppsStamp;
+	interrupts();
+
+	if (count == ppsLastCount) {
+		if ((discipline == discipline_locked) && (millis() - ppsMillis > ppsTimeout)) discipline = discipline_holdover;
+		return;
+	}
+
+	byte pulses = count - ppsLastCount;
+	long deviation = (long)(stamp - ppsLastStamp) - 1000000;
+
+	ppsLastCount = count;
+	ppsLastStamp = stamp;
+	ppsMillis = millis();
+	if (discipline == discipline_holdover) discipline = discipline_acquiring;
+
+	if ((pulses != 1) || !ppsBlockValid || (labs(deviation) > ppsTolerance)) {
+		ppsBlockStamp = stamp;
+		ppsBlockCount = 0;
+		ppsBlockValid = true;
+		return;
+	}
+
+	if (++ppsBlockCount < ppsBlockLength) return;
+
+	filterDiscipline(((long)(stamp - ppsBlockStamp) - (long)ppsBlockCount * 1000000) * 1000 / ppsBlockCount);
+	ppsBlockStamp = stamp;
+	ppsBlockCount = 0;
+}
+
+//*********************************************************************************************************
+// filterDiscipline
+// Loop filter: exponential average of the block measures (ppb). The first measure initializes it.
+// Locks after disciplineLockBlocks successive measures close to the estimate and then applies the estimate to calibration.
+// The first lock is saved to EEPROM so that the board restarts close to it, the following updates are not to spare the EEPROM.
+void Pandauino_Freq_LF_VHF::filterDiscipline(long measure) {
+
+	if (disciplineBlocks == 0) disciplineAccumulator = measure * (1L << disciplineFilterShift);
+	else {
+		if (labs(measure - disciplinePpb) <= disciplineLockPpb) {
+			if (lockCount < 255) lockCount++;
+		}
+		else lockCount = 0;
+		disciplineAccumulator += measure - (disciplineAccumulator >> disciplineFilterShift);
+	}
+	if (disciplineBlocks < 255) disciplineBlocks++;
+	disciplinePpb = disciplineAccumulator >> disciplineFilterShift;
+
+	if (lockCount < disciplineLockBlocks) {
+		if (discipline == discipline_locked) discipline = discipline_acquiring;
+		return;
+	}
+
+	// calibrationStep() owns calibration while it runs
+	if ((state == state_calibration_skip) || (state == state_calibration_gate)) return;
+
+	calibration = 1.0 + disciplinePpb / 1000000000.0;
+	configureMultipliers();
+
+	if (discipline != discipline_locked) settingsChanged();
+	discipline = discipline_locked;
+}
+
+/* ************************************************************************************************************************************
+  STABILITY FUNCTIONS
+**************************************************************************************************************************************/
+
+#ifdef FREQ_ENABLE_ADEV
+//*********************************************************************************************************
+// allanSample
+// Adds a gate result to the overlapping Allan deviation. With the results y kept as deviations from the first one,
+// each octave sums the squares of D = (sum of the last m results) - (sum of the m before), m = 2^octave, over all the overlapping positions.
+// Both factors of the squares are kept below 2^31 and the sums below 2^62 by raising allanShift, so the 64 bit sums cannot overflow.
+void Pandauino_Freq_LF_VHF::allanSample(int64_t freq) {
+
+	int64_t deviation;
+	int64_t difference;
+	uint64_t term;
+	unsigned int m;
+	byte index;
+
+	if (!allanEnabled) return;
+
+	// restarts from this result when the gate time changed or the frequency moved more than the 32 bits of allanHistory
+	deviation = freq - allanReference;
+	if ((allanCount == 0) || (gateTime != allanGateTime) || (deviation > 2147483647LL) || (deviation < -2147483647LL)) {
+		resetAllan();
+		allanReference = freq;
+		allanGateTime = gateTime;
+		deviation = 0;
+	}
+
+	allanHistory[allanIndex] = deviation;
+	allanIndex = (allanIndex + 1) & (ALLAN_HISTORY - 1);
+	allanCount++;
+
+	for (byte octave = 0; octave < ALLAN_OCTAVES; octave++) {
+
+		m = 1 << octave;
+		if (allanCount < 2UL * m) break;
+
+		difference = 0;
+		index = allanIndex;
+		for (unsigned int i = 0; i < 2 * m; i++) {
+			index = (index - 1) & (ALLAN_HISTORY - 1);
+			if (i < m) difference += allanHistory[index];
+			else difference -= allanHistory[index];
+		}
+		if (difference < 0) difference = -difference;
+
+		while (((difference >> allanShift[octave]) >= (1LL << 31)) || (allanSum[octave] >= (1ULL << 62))) {
+			allanShift[octave]++;
+			allanSum[octave] >>= 2;
+		}
+
+		term = difference >> allanShift[octave];
+		allanSum[octave] += term * term;
+	}
+
+}
+
+//*********************************************************************************************************
+// allanStep
+// Called by freqCount(). Every allanReportPeriod, when there are new gate results, the Allan deviations are computed
+// and printed one octave per call, only when the serial transmit buffer can take the whole line: it never waits.
+// The I2C registers are updated at the end of the report.
+void Pandauino_Freq_LF_VHF::allanStep() {
+
+	double deviation;
+	bool toSerial = allanPrint && outputToSerial && (outputFormat == serial_ascii);
+
+	if (!allanEnabled) return;
+
+	if (allanReportOctave == 0) {
+		if (((millis() - allanReportStamp) < allanReportPeriod) || (allanCount == allanReportedCount)) return;
+		allanReportStamp = millis();
+		allanReportedCount = allanCount;
+	}
+
+	if (toSerial && (Serial.availableForWrite() < allanLineLength)) return;
+
+	deviation = getAllanDeviation(allanReportOctave) * 1000000000000.0;
+	allanValue[allanReportOctave] = (deviation < 4294967295.0) ? (unsigned long)(deviation + 0.5) : 4294967295UL;
+
+	if (toSerial && (allanValue[allanReportOctave] != 0)) serialPrintAllan(allanReportOctave);
+
+	allanReportOctave++;
+	if (allanReportOctave < ALLAN_OCTAVES) return;
+
+	allanReportOctave = 0;
+#ifdef FREQ_ENABLE_I2C
+	if (i2cAddress != 0) updateI2CSnapshot(false, 0);
+#endif
+
 }
 
-// ************************************************************************************************************************************
-// measureLF
-// Measure using freqMeasure
-double Pandauino_Freq_LF_VHF::measureLF() {
+//*********************************************************************************************************
+// resetAllan
+// Restarts the Allan deviation, when the gate results are not contiguous anymore
+void Pandauino_Freq_LF_VHF::resetAllan() {
+
+	allanIndex = 0;
+	allanCount = 0;
+	allanReportedCount = 0;
+	allanReportOctave = 0;
+	for (byte octave = 0; octave < ALLAN_OCTAVES; octave++) {
+		allanSum[octave] = 0;
+		allanShift[octave] = 0;
+		allanValue[octave] = 0;
+	}
 
-	double freq = 0.0;
+}
 
-	if (FreqMeasure.available()) {
-		countLF = FreqMeasure.read();
-		freq = FreqMeasure.countToFrequency(countLF) * prescalerCoef * calibration;
+//*********************************************************************************************************
+// serialPrintAllan
+// Prints the Allan deviation of an octave with 4 digits, e.g. "ADEV 400 ms 1.234e-9"
+void Pandauino_Freq_LF_VHF::serialPrintAllan(byte octave) {
+
+	unsigned long mantissa = allanValue[octave];
+	int exponent = -9;							// allanValue is in 1E-12: 1000 is 1.000e-9
+
+	while (mantissa >= 10000) {
+		mantissa = (mantissa + 5) / 10;
+		exponent++;
+	}
+	while (mantissa < 1000) {
+		mantissa *= 10;
+		exponent--;
 	}
 
-	return freq;
+	Serial.print("ADEV ");
+	Serial.print((allanGateTime << octave) / 1000);
+	Serial.print(" ms ");
+	Serial.print(mantissa / 1000);
+	Serial.print('.');
+	for (unsigned long digit = 100; digit > mantissa % 1000; digit /= 10) Serial.print('0');
+	if (mantissa % 1000 != 0) Serial.print(mantissa % 1000);
+	Serial.print('e');
+	Serial.println(exponent);
 
 }
+#endif
 
-// ************************************************************************************************************************************
-// measureHF
-// Measure using freqCount
-double Pandauino_Freq_LF_VHF::measureHF_VHF() {
+//*********************************************************************************************************
+// updateDrift
+// Called by displayMeasurement() each time lastValidFrequency is updated, at most every displayTimeLap.
+// The drift rate is the change of lastValidFrequency over at least driftInterval, divided by the time between the two measures,
+// then averaged by an exponential moving average. Nothing waits: a measure shorter than driftInterval is just left for a later call.
+void Pandauino_Freq_LF_VHF::updateDrift() {
+
+	unsigned long now = millis();
+	unsigned long span = now - driftStamp;
+	int64_t rate;
+
+	if (settleMaxDrift == 0) return;
+
+	if (driftFrequency == 0) {
+		driftFrequency = lastValidFrequency;
+		driftStamp = now;
+		settledStamp = now;
+		return;
+	}
 
-	double freq = 0.0;
+	if (span < driftInterval) return;
 
-	if (FreqCount.available()) {
-		freq = FreqCount.read() * prescalerCoef  * calibration;
+	rate = (lastValidFrequency - driftFrequency) * 1000 / (int64_t)span;
+	driftFrequency = lastValidFrequency;
+	driftStamp = now;
+
+	if (driftValid) driftRate += (rate - driftRate) / (1 << driftFilterShift);
+	else driftRate = rate;
+	driftValid = true;
+
+	// settled once the drift rate stayed under the threshold for settleTime
+	if ((driftRate > (int64_t)settleMaxDrift) || (driftRate < -(int64_t)settleMaxDrift)) {
+		settledStamp = now;
+		settled = false;
 	}
+	else if ((now - settledStamp) >= settleTime) settled = true;
 
-	return freq;
+	if (settlePrint && outputToSerial && (outputFormat == serial_ascii) && (Serial.availableForWrite() >= driftLineLength)) {
+		Serial.print(settled ? "SETTLED " : "SETTLING ");
+		serialPrintMicroHertz(driftRate);
+	}
+
+#ifdef FREQ_ENABLE_I2C
+	if (i2cAddress != 0) updateI2CSnapshot(false, 0);
+#endif
+
+}
+
+void Pandauino_Freq_LF_VHF::resetDrift() {
+	driftFrequency = 0;
+	driftRate = 0;
+	driftValid = false;
+	settled = false;
 }
 
 /* ************************************************************************************************************************************
@@ -929,82 +2797,213 @@ double Pandauino_Freq_LF_VHF::measureHF_VHF() {
 **************************************************************************************************************************************/
 
 // *********************************************************************************************************
-// Reads parameters stored in EEPROM
-void Pandauino_Freq_LF_VHF::readAllFromEEPROM() {
-
-  byte init = EEPROM.read(EEPROMbaseAddress);
-
-  if (init == eepromInit) {
-		EEPROM_readAnything(addressOfMode, mode);
-		EEPROM_readAnything(addressOfBand, band);
-		EEPROM_readAnything(addressOfResolution, resolution);
-		EEPROM_readAnything(addressOfCalibration, calibration);
-		EEPROM_readAnything(addressOfMeasurementType, measurementType);
-		EEPROM_readAnything(addressOfOperation, operation);
-		EEPROM_readAnything(addressOfSleepSetting, sleepSetting);
-		EEPROM_readAnything(addressOfRefFrequency, refFrequency);
-  }
-  else updateAllToEEPROM();
+// Settings journal
+// The settings are stored as a 41 bytes record, little endian:
+//
+// offset size
+//  0     1   settingsVersion
+//  1     4   sequence number, incremented at each record written
+//  5     6   mode, band, resolution, measurementType, operation, sleepSetting
+// 11     4   calibration - 1 in ppb, signed
+// 15     8   refFrequency (uHz), signed
+// 23    16   bandCalibrationPpb[4], signed
+// 39     2   CRC-16/CCITT-FALSE of bytes 0 to 38
+//
+// Version 1 records had no bandCalibrationPpb, their CRC was at offset 23, and were in 32 bytes slots.
+//
+// Each record goes to the next settingsSlotSize slot of the EEPROM, wrapping at its end, so that the writes are spread over all of it.
+// The valid record with the highest sequence number holds the current settings.
+// The version byte of the slot is cleared first and written last: a record cut by a power loss is never valid,
+// whatever the slot held before, and the previous one stays in use.
+
+// *********************************************************************************************************
+// Loads the settings at power up: a single scan of the EEPROM for the last valid record, every 32 bytes to find version 1 ones too
+// Without one, the settings of the former fixed addresses layout are migrated if present, otherwise the defaults are stored
+void Pandauino_Freq_LF_VHF::loadSettings() {
+
+	int address;
+	int lastAddress = 0;
+	bool found = false;
+	unsigned long sequence;
+
+	for (address = 0; address < EEPROM.length(); address += 32) {
+
+		readSettingsRecord(address);
+		if (settingsRecordLengthOf() == 0) continue;
+
+		sequence = getBytes(settingsBuffer, 1, 4);
+		if (found && ((long)(sequence - settingsSequence) <= 0)) continue;
+
+		found = true;
+		lastAddress = address;
+		settingsSequence = sequence;
+	}
+
+	if (found) {
+		readSettingsRecord(lastAddress);
+		settingsSlot = lastAddress / settingsSlotSize;
+
+		mode = (measurementMode)checkedSetting(settingsBuffer[5], mode_band, mode_auto);
+		band = (measurementBand)checkedSetting(settingsBuffer[6], band_VHF2, band_HF);
+		resolution = (measurementResolution)checkedSetting(settingsBuffer[7], resolution_ultra_high, resolution_normal);
+		measurementType = (measurementDisplayType)checkedSetting(settingsBuffer[8], measure_period, measure_frequency);
+		operation = (operationType)checkedSetting(settingsBuffer[9], operation_if_minus, operation_none);
+		sleepSetting = (sleepMode)checkedSetting(settingsBuffer[10], sleep_disabled, sleep_5m);
+		calibration = 1.0 + checkedCalibrationPpb((int32_t)getBytes(settingsBuffer, 11, 4)) / 1000000000.0;
+		refFrequency = (int64_t)(((uint64_t)getBytes(settingsBuffer, 19, 4) << 32) | getBytes(settingsBuffer, 15, 4));
+
+		if (settingsBuffer[0] == settingsVersion) {
+			for (byte i = 0; i < 4; i++) bandCalibrationPpb[i] = checkedCalibrationPpb((int32_t)getBytes(settingsBuffer, 23 + 4 * i, 4));
+		} else {
+			settingsChanged();			// rewritten in the current version
+		}
+		return;
+	}
+
+	// the last slot so that the first record goes to slot 0
+	settingsSlot = EEPROM.length() / settingsSlotSize - 1;
+	settingsSequence = 0;
+
+	if (EEPROM.read(0) == legacyEepromInit) readLegacySettings();
+	settingsChanged();
 
 }
 
 //*********************************************************************************************************
-// Retrieves reference frequency from EEPROM
-void Pandauino_Freq_LF_VHF::readFromEEPROM_refFrequency(){
-	EEPROM_readAnything(addressOfRefFrequency, refFrequency);
-}
+// Reads the record at address into settingsBuffer
+void Pandauino_Freq_LF_VHF::readSettingsRecord(int address) {
 
+	for (byte i = 0; (i < settingsRecordLength) && (address + i < EEPROM.length()); i++) settingsBuffer[i] = EEPROM.read(address + i);
 
-//*********************************************************************************************************
-// Updates parameters stored in EEPROM
-void Pandauino_Freq_LF_VHF::updateToEEPROM_init(){
-	EEPROM_writeAnything(EEPROMbaseAddress, eepromInit);
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_mode(){
-	EEPROM_writeAnything(addressOfMode, mode);
-}
+//*********************************************************************************************************
+// Reads the settings of the former layout: eepromInit at address 0 then each field at a fixed address
+// The refFrequency was kept in Hz in a double
+void Pandauino_Freq_LF_VHF::readLegacySettings() {
+
+	int address = 1;
+	int value;								// the enums were stored as int
+	double storedCalibration;
+	double storedFrequency;
+
+	address += EEPROM_readAnything(address, value);
+	mode = (measurementMode)checkedSetting(value, mode_band, mode_auto);
+	address += EEPROM_readAnything(address, value);
+	band = (measurementBand)checkedSetting(value, band_VHF2, band_HF);
+	address += EEPROM_readAnything(address, value);
+	resolution = (measurementResolution)checkedSetting(value, resolution_ultra_high, resolution_normal);
+	address += EEPROM_readAnything(address, storedCalibration);
+	address += EEPROM_readAnything(address, value);
+	measurementType = (measurementDisplayType)checkedSetting(value, measure_period, measure_frequency);
+	address += EEPROM_readAnything(address, value);
+	operation = (operationType)checkedSetting(value, operation_if_minus, operation_none);
+	address += EEPROM_readAnything(address, value);
+	sleepSetting = (sleepMode)checkedSetting(value, sleep_disabled, sleep_5m);
+	EEPROM_readAnything(address, storedFrequency);
+
+	// written as !(a < b) so that a NaN is rejected too
+	if (!(abs(storedCalibration - 1.0) < maxStoredCalibrationPpb / 1000000000.0)) storedCalibration = 1.0;
+	if (!(abs(storedFrequency) < 1000000000.0)) storedFrequency = 0.0;
+	calibration = storedCalibration;
+	refFrequency = storedFrequency * 1000000;
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_band(){
-	EEPROM_writeAnything(addressOfBand, band);
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_resolution(){
-	EEPROM_writeAnything(addressOfResolution, resolution);
-}
+//*********************************************************************************************************
+// Returns the setting read when it is a value of its enum, from 0 to last, otherwise its default
+byte Pandauino_Freq_LF_VHF::checkedSetting(int value, byte last, byte byDefault) {
+
+	if ((value < 0) || (value > last)) return byDefault;
+	return value;
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_calibration(){
-	EEPROM_writeAnything(addressOfCalibration, calibration);
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_measurementType(){
-	EEPROM_writeAnything(addressOfMeasurementType, measurementType);
+//*********************************************************************************************************
+// Returns the calibration read (ppb), 0 when it is too large to be one
+long Pandauino_Freq_LF_VHF::checkedCalibrationPpb(long value) {
+
+	if ((value > maxStoredCalibrationPpb) || (value < -maxStoredCalibrationPpb)) return 0;
+	return value;
+
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_operation(){
-	EEPROM_writeAnything(addressOfOperation, operation);
+//*********************************************************************************************************
+// Checks the version and CRC of the record in settingsBuffer. Returns its length, 0 if it is not valid
+byte Pandauino_Freq_LF_VHF::settingsRecordLengthOf() {
+
+	uint16_t crc = 0xFFFF;
+	byte length;
+
+	if (settingsBuffer[0] == settingsVersion) length = settingsRecordLength;
+	else if (settingsBuffer[0] == 1) length = 25;
+	else return 0;
+
+	for (byte i = 0; i < length - 2; i++) crc = crc16Update(crc, settingsBuffer[i]);
+	if (crc != getBytes(settingsBuffer, length - 2, 2)) return 0;
+
+	return length;
+
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_sleepSetting(){
-	EEPROM_writeAnything(addressOfSleepSetting, sleepSetting);
+//*********************************************************************************************************
+// Called when a setting was changed. The settings are written settingsFlushDelay after the last change, all of them in one record
+void Pandauino_Freq_LF_VHF::settingsChanged() {
+
+	settingsDirty = true;
+	settingsStamp = millis();
+
 }
 
-void Pandauino_Freq_LF_VHF::updateToEEPROM_refFrequency(){
-	EEPROM_writeAnything(addressOfRefFrequency, refFrequency);
+//*********************************************************************************************************
+// settingsStep
+// Called by freqCount(). Starts writing a record when the settings changed, and writes one byte per call
+// so that the loop is never blocked for the 3.3 ms of each EEPROM byte write more than once.
+void Pandauino_Freq_LF_VHF::settingsStep() {
+
+	uint16_t crc = 0xFFFF;
+	byte i;
+
+	if (settingsWriteIndex <= settingsRecordLength) {
+		// 0 in the version byte first, then bytes 1 to 40 and the version byte
+		i = settingsWriteIndex % settingsRecordLength;
+		EEPROM.update(settingsSlot * settingsSlotSize + i, (settingsWriteIndex == 0) ? 0 : settingsBuffer[i]);
+		settingsWriteIndex++;
+		return;
+	}
+
+	if (!settingsDirty || ((millis() - settingsStamp) < settingsFlushDelay)) return;
+
+	settingsDirty = false;
+	settingsSlot = (settingsSlot + 1) % (EEPROM.length() / settingsSlotSize);
+	settingsSequence++;
+
+	settingsBuffer[0] = settingsVersion;
+	i = putBytes(settingsBuffer, 1, settingsSequence, 4);
+	settingsBuffer[i++] = mode;
+	settingsBuffer[i++] = band;
+	settingsBuffer[i++] = resolution;
+	settingsBuffer[i++] = measurementType;
+	settingsBuffer[i++] = operation;
+	settingsBuffer[i++] = sleepSetting;
+	i = putBytes(settingsBuffer, i, lround((calibration - 1.0) * 1000000000.0), 4);
+	i = putBytes(settingsBuffer, i, (unsigned long)refFrequency, 4);
+	i = putBytes(settingsBuffer, i, (unsigned long)(refFrequency >> 32), 4);
+	for (byte j = 0; j < 4; j++) i = putBytes(settingsBuffer, i, bandCalibrationPpb[j], 4);
+	for (byte j = 0; j < i; j++) crc = crc16Update(crc, settingsBuffer[j]);
+	putBytes(settingsBuffer, i, crc, 2);
+
+	settingsWriteIndex = 0;
 
 }
 
-void Pandauino_Freq_LF_VHF::updateAllToEEPROM() {
+//*********************************************************************************************************
+// Invalidates all the records, and the former layout, so that the defaults are used at the next power up
+void Pandauino_Freq_LF_VHF::eraseSettings() {
 
-	updateToEEPROM_init();
-	updateToEEPROM_mode();
-	updateToEEPROM_band();
-	updateToEEPROM_resolution();
-	updateToEEPROM_calibration();
-	updateToEEPROM_measurementType();
-	updateToEEPROM_operation();
-	updateToEEPROM_sleepSetting();
-	updateToEEPROM_refFrequency();
+	for (int address = 0; address < EEPROM.length(); address += 32) EEPROM.update(address, 0);
+	settingsWriteIndex = settingsRecordLength + 1;
+	settingsDirty = false;
 
 }
 
@@ -1030,28 +3029,18 @@ void Pandauino_Freq_LF_VHF::setSleepTimeout() {
 void Pandauino_Freq_LF_VHF::initVcc() {
 
   // initializes the ADC: clock prescaler 128, Ref AVCC, input ADC7
-  ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) |(1<<ADPS0) ;
-  ADMUX =  (1<<REFS0) | 0x07; // Ref AVCC, input ADC7
+  halInitAdc();
 
 }
 
 //*********************************************************************************************************
 // readVcc()
-// gives the voltage applied through a resistor network divider to ADC0, in millivolts
-// using an external reference applied to AREF pin
+// gives the voltage applied through a resistor network divider to ADC7, in volts
 float Pandauino_Freq_LF_VHF::readVcc() {
 
-  ADCSRA |= _BV(ADEN); 								// Start ADC
-  delay(2); 													// Wait for Vref to settle
-  ADCSRA |= _BV(ADSC); 								// Start conversion
-  while (bit_is_set(ADCSRA, ADSC)); 	// measuring
+  float result = halReadAdc();
 
-  uint8_t low  = ADCL; // must read ADCL first - it then locks ADCH
-  uint8_t high = ADCH; // unlocks both
-
-  float result = (high << 8) | low;
-
-  result = result * coefVcc;   // Computes Vcc (in mV);
+  result = result * coefVcc;   // Computes Vcc (in V);
 
   return result;
 }
@@ -1059,42 +3048,48 @@ float Pandauino_Freq_LF_VHF::readVcc() {
 
 //*********************************************************************************************************
 // VccTest()
-// detects under or over VCC voltages
+// used at startup: waits until the power voltage is within the limits
+void Pandauino_Freq_LF_VHF::VccTest() {
+
+  voltageError = false;
+
+  do {
+    VccCheck();
+    if (voltageError) delay(vccDelayPeriod);
+  } while (voltageError);
+
+}
+
+//*********************************************************************************************************
+// VccCheck()
+// detects under or over VCC voltages with a single reading
 // triggers vcc error when vcc is outside of underVoltageMinusHysteresis or overVoltagePlusHysteresis values
 // maintains vcc error condition as long as vcc is not between underVoltage and overVoltage values
-void Pandauino_Freq_LF_VHF::VccTest() {
+void Pandauino_Freq_LF_VHF::VccCheck() {
 
-  float avgVcc = 0.0;
   float vcc = 0.0;
 
-  voltageError = false;
-  power_adc_enable();
-  delay(1);
+  halAdcPower(true);
 
-  do {
-    vcc = readVcc();
-
-    if (vcc < underVoltageMinusHysteresis) {
-      if (!voltageError) {
-  			printSixteenCharToLCD(msgVoltageTooLow);
-  		}
-      voltageError = true;
-    } else if (vcc > overVoltagePlusHysteresis) {
-      if (!voltageError) {
-	    	printSixteenCharToLCD(msgVoltageTooHigh);
-      }
-      voltageError = true;
-    }
+  vcc = readVcc();
 
-    if ((vcc > underVoltage) and (vcc < overVoltage)) {
-      voltageError = false;
+  if (vcc < underVoltageMinusHysteresis) {
+    if (!voltageError) {
+			printSixteenCharToLCD(msgVoltageTooLow);
+		}
+    voltageError = true;
+  } else if (vcc > overVoltagePlusHysteresis) {
+    if (!voltageError) {
+    	printSixteenCharToLCD(msgVoltageTooHigh);
     }
+    voltageError = true;
+  }
 
-    delay(vccDelayPeriod);
-
-  } while (voltageError);
+  if ((vcc > underVoltage) and (vcc < overVoltage)) {
+    voltageError = false;
+  }
 
-  power_adc_disable();
+  halAdcPower(false);
 }
 
 //*********************************************************************************************************
@@ -1120,39 +3115,37 @@ bool Pandauino_Freq_LF_VHF::timeToTestVCC() {
 **************************************************************************************************************************************/
 
 //*********************************************************************************************************
-// Needed to use 1 line LCD because it displays 2 * 8 chars on one line
-void Pandauino_Freq_LF_VHF::sixteenTo8chars (char inputChar[17], char outputChar1[8], char outputChar2[8] ) {
+// Used to print a line on the LCD
+void Pandauino_Freq_LF_VHF::printSixteenCharToLCD (const char toPrint[17]) {
 
-  // cuts a char[17] into 2 * char[8]
+  // prints a char[17] message to a 16*1 LCD screen configured as 2*8 characters on one line
+  // only the characters differing from lcdShadow are sent, without lcd.clear() which takes about 2 ms and makes the screen flicker
+  // a message shorter than 16 characters is completed with spaces
 
-  int i = 0;
+  char c;
+  byte nextPosition = 16;				// position where the LCD cursor stands after the last write, 16 meaning unknown
+  bool ended = false;
 
-  for (i = 0; i < 8; i++){
-       outputChar1[i] = inputChar[i];
-  }
+  for (byte i = 0; i < 16; i++) {
 
-  for (i = 8; i < 16; i++){
-       outputChar2[i-8] = inputChar[i];
+    if (toPrint[i] == 0) ended = true;
+    c = ended ? ' ' : toPrint[i];
+
+    if (c != lcdShadow[i]) {
+      // the cursor does not go from the first 8 chars half to the second one by itself: they are 2 LCD lines
+    	if ((i != nextPosition) || (i == 8)) lcd.setCursor(i % 8, i / 8);
+      lcd.write(c);
+      lcdShadow[i] = c;
+      nextPosition = i + 1;
+    }
   }
 }
 
-
 //*********************************************************************************************************
-// Used to print a line on the LCD
-void Pandauino_Freq_LF_VHF::printSixteenCharToLCD (char toPrint[17]) {
-
-  // prints a char[17] message to a 16*1 LCD screen configured as 2*8 characters on one line
-
-   char out1[8];
-   char out2[8];
-
-   sixteenTo8chars (toPrint , out1, out2);
+// Forces the next printSixteenCharToLCD() to write all the characters, when the LCD content is not known
+void Pandauino_Freq_LF_VHF::invalidateLCDShadow() {
 
-   lcd.clear();
-   lcd.setCursor(0,0);
-   lcd.print(out1);
-   lcd.setCursor(0,1);
-   lcd.print(out2);
+  for (byte i = 0; i < 16; i++) lcdShadow[i] = 0;
 }
 
 //*********************************************************************************************************
@@ -1160,65 +3153,70 @@ void Pandauino_Freq_LF_VHF::printSixteenCharToLCD (char toPrint[17]) {
 // Either this value is the product of an operation or not
 void Pandauino_Freq_LF_VHF::displayFrequency() {
 
-  double displayMeasure = 0.0;
-  double displayRef = 0.0;
+  int64_t unitValue;												// uHz in one displayed unit
+  int64_t absoluteFrequency;
+  int64_t roundingStep;
+  const char *unit;
   byte effectiveDisplayPrecision;
-
-  String unit = "";
   byte nbOfIntDigits = 0;
   byte nbOfDecimals = 0;
+  byte position;
 
   if (abs(frequency) >= 1000000.0) {					// We use the frequency and not the resultFrequency to display coherently with the actual frequency range
-    displayMeasure = resultFrequency / 1000000;
-    unit.concat(" MHz ");
+    unitValue = 1000000000000LL;
+    unit = " MHz ";
   }
   else if (abs(frequency) >= 1000.0){
-    displayMeasure = resultFrequency / 1000;
-    unit.concat(" KHz ");
+    unitValue = 1000000000LL;
+    unit = " KHz ";
   }
 	else {
-    displayMeasure = resultFrequency;
-    unit.concat(" Hz ");
+    unitValue = 1000000LL;
+    unit = " Hz ";
 	}
 
 	if (frequency<10000.0) { effectiveDisplayPrecision = displayPrecision -1; }
 	else { effectiveDisplayPrecision = displayPrecision ; }
 
-  nbOfIntDigits = countIntDigits(displayMeasure);
+  absoluteFrequency = (resultFrequency < 0) ? -resultFrequency : resultFrequency;
+
+  for (roundingStep = absoluteFrequency / unitValue; roundingStep != 0; roundingStep /= 10) nbOfIntDigits++;
 
+  // effectiveDisplayPrecision digits in all, one of them being the 0 before the point below 1
   if (nbOfIntDigits == 0) {
-  	nbOfDecimals = effectiveDisplayPrecision - nbOfIntDigits - 1;
+  	nbOfDecimals = effectiveDisplayPrecision - 1;
   }
-  else {
+  else if (nbOfIntDigits < effectiveDisplayPrecision) {
     nbOfDecimals = effectiveDisplayPrecision - nbOfIntDigits;
   }
 
-  // patch whenever some float comparison turns false (foar example at 100 Khz exactly)
-  if ((nbOfIntDigits + nbOfDecimals) > effectiveDisplayPrecision)  nbOfDecimals--;
-
-  dtostrf(displayMeasure, effectiveDisplayPrecision, nbOfDecimals, text1);
+  // rounds to the last decimal displayed
+  roundingStep = unitValue;
+  for (byte i = 0; i < nbOfDecimals; i++) roundingStep /= 10;
 
-  text = (String)text1;
-
-  text.concat(unit);
+  position = 0;
+  if (resultFrequency < 0) position = appendText(position, "-");
+  position = appendFixed(position, (absoluteFrequency + roundingStep / 2) / roundingStep, nbOfDecimals);
+  position = appendText(position, unit);
+  if ((settleMaxDrift > 0) && settled) line1[position - 1] = '*';
 
 	if (operation != operation_none) {
-		if (operation == operation_vfo_plus) text.concat("V+I");
-		if (operation == operation_vfo_minus) text.concat("V-I");
-		if (operation == operation_if_minus) text.concat("I-F");
+		if (operation == operation_vfo_plus) position = appendText(position, "V+I");
+		if (operation == operation_vfo_minus) position = appendText(position, "V-I");
+		if (operation == operation_if_minus) position = appendText(position, "I-F");
 	}
 	else {
-		if (mode == mode_auto) text.concat("AUT");
-		if ((mode == mode_band) and (band == band_LF)) text.concat("LF");
-		if ((mode == mode_band) and (band == band_HF)) text.concat("HF");
-		if ((mode == mode_band) and (band == band_VHF1)) text.concat("VH1");
-		if ((mode == mode_band) and (band == band_VHF2)) text.concat("VH2");
+		if (mode == mode_auto) position = appendText(position, "AUT");
+		if ((mode == mode_band) and (band == band_LF)) position = appendText(position, "LF");
+		if ((mode == mode_band) and (band == band_HF)) position = appendText(position, "HF");
+		if ((mode == mode_band) and (band == band_VHF1)) position = appendText(position, "VH1");
+		if ((mode == mode_band) and (band == band_VHF2)) position = appendText(position, "VH2");
 	}
 
-  text.toCharArray(line1, 17);  // reconvertir en char[17] y compris un caractre vide ncessaire
+  endLine(position);
   printSixteenCharToLCD(line1);
 
-  if (outputToSerial) Serial.println(resultFrequency,7);
+  if (outputToSerial && (outputFormat == serial_ascii)) serialPrintMicroHertz(resultFrequency);
 
 }
 
@@ -1228,72 +3226,59 @@ void Pandauino_Freq_LF_VHF::displayFrequency() {
 // Either this value is the product of an operation or not
 void Pandauino_Freq_LF_VHF::displayPeriod() {
 
-  double period = 1/resultFrequency;
-  byte displayPrecision = 4;
-
-  byte i = 1;
-  String unit = " E-";
-  double periodPow = 0.0;
-  int entirePart = 0;
-  double decimalPart = 0.0;
-
-  // computation is complicated because of approximation in the comparison entirePart > 0
-  // due to the resolution of float. Hence the check if the entirePart is "10"
-
-  for (i=1; i<10; i++) {
-		periodPow = period * pow(10,i);
-  	entirePart = (int) (period * pow(10,i));
-		decimalPart = periodPow - entirePart;
-  	if (abs(entirePart) > 0) break;
+  // The period is 10^6 / resultFrequency s, resultFrequency being in uHz
+  // It is displayed as mantissa E-exponent, the mantissa being in [1, 10[ whenever the period is less than 0.1 s
+  // Both come from an integer long division of a power of ten by the frequency: exact, without float nor libm
+
+  int64_t divisor = (resultFrequency < 0) ? -resultFrequency : resultFrequency;
+  int64_t dividend = 10000000LL;										// 10^6 * 10^exponent
+  int64_t remainder;
+  long mantissa;
+  long mantissaMax = 10;
+  byte exponent = 1;
+  byte nbOfDecimals = 3 + resolution - resolution_low;
+  byte position = 0;
+
+  if (divisor == 0) {
+  	endLine(appendText(0, "---- s "));
+    printSixteenCharToLCD(line1);
+    return;
   }
 
-
-  if (abs(entirePart) == 10) {
-
-    // cover the case of an error of the test (entirePart > 0) due to approximation in float operation
-  	periodPow = (entirePart + decimalPart) / 10;
-		i--;
-
-  } else {
-
-    // manually floors the decimals to avoid an error of ceiling the value to 10 due to approximation in float operation
-    // there might be an error remaining for negative values
-		decimalPart *= 100000;
-		decimalPart = floor(decimalPart);
-		decimalPart /= 100000;
-		periodPow = entirePart + decimalPart;
-
+  // smallest exponent giving a mantissa of at least 1
+  while ((dividend < divisor) && (exponent < 9)) {
+    dividend *= 10;
+    exponent++;
   }
 
-	switch (resolution) {
-
-		case resolution_low:
-	  dtostrf(periodPow, 4, 3, text1);
-		break;
-
-		case resolution_normal:
-	  dtostrf(periodPow, 5, 4, text1);
-		break;
-
-		case resolution_high:
-	  dtostrf(periodPow, 6, 5, text1);
-		break;
-
-		case resolution_ultra_high:
-	  dtostrf(periodPow, 7, 6, text1);
-		break;
-	}
+  mantissa = dividend / divisor;
+  remainder = dividend % divisor;
 
-  text = (String)text1;
+  // one decimal at a time: the remainder stays below the frequency so never overflows
+  for (byte i = 0; i < nbOfDecimals; i++) {
+    remainder *= 10;
+    mantissa = mantissa * 10 + remainder / divisor;
+    remainder %= divisor;
+    mantissaMax *= 10;
+  }
 
-  unit.concat(i);
-  unit.concat(" s ");
+  // rounds the last decimal, 9.9996 E-3 becoming 1.000 E-2
+  if (2 * remainder >= divisor) mantissa++;
+  if ((mantissa >= mantissaMax) && (exponent > 1)) {
+    mantissa /= 10;
+    exponent--;
+  }
 
-  text.concat(unit);
-  text.toCharArray(line1, 17);
+  if (resultFrequency < 0) position = appendText(position, "-");
+  position = appendFixed(position, mantissa, nbOfDecimals);
+  position = appendText(position, " E-");
+  position = appendFixed(position, exponent, 0);
+  position = appendText(position, " s ");
+  if ((settleMaxDrift > 0) && settled) line1[position - 1] = '*';
+  endLine(position);
   printSixteenCharToLCD(line1);
 
-  if (outputToSerial) Serial.println(resultFrequency,7);
+  if (outputToSerial && (outputFormat == serial_ascii)) serialPrintMicroHertz(resultFrequency);
 
 }
 
@@ -1305,8 +3290,6 @@ boolean Pandauino_Freq_LF_VHF::testFrequencyOutOfRange() {
 
  	if 	((band==band_HF) && (frequency < freqHFmin)) {
 		error = true;
-		text = "f < ";
-   	dtostrf(freqHFmin, 8, 0, text1);
 	}
 
  	if 	((band==band_VHF1) && (frequency < freqVHF1min)) {
@@ -1346,21 +3329,27 @@ boolean Pandauino_Freq_LF_VHF::testFrequencyOutOfRange() {
 // Main routine for displaying measurement value and parameters
 void Pandauino_Freq_LF_VHF::displayMeasurement() {
 
+	// a message is held on the LCD
+	if (messageHeld()) return;
+
   // in LF band, when trying to display measurement before the displayTimeLap is elapsed, sums the value
   // this is to avoid scintillation of the LCD and to increase averaging
   // displayTimeLap may be reduced if willing to get more frequent results (to PC as an example)
+  // Each measure is weighted by its clock ticks (rawCount) so that the average is all the periods over all the ticks
 
   if (band == band_LF) {
 
+    sumDisplayFreqTicks = sumDisplayFreqTicks + frequencyMicroHertz * rawCount;
+    sumDisplayTicks = sumDisplayTicks + rawCount;
+
     if ((millis() - displayStamp) < displayTimeLap) {
-      sumDisplayFreq = sumDisplayFreq + frequency;
-      nbAvgDisplayFreq = nbAvgDisplayFreq + 1;
       return;
     }
     else { // computes the average value
-      frequency = (frequency + sumDisplayFreq) / (nbAvgDisplayFreq + 1);
-      sumDisplayFreq = 0.0;
-      nbAvgDisplayFreq = 0;
+      if (sumDisplayTicks > 0) frequencyMicroHertz = (sumDisplayFreqTicks + sumDisplayTicks / 2) / sumDisplayTicks;
+      frequency = frequencyMicroHertz / 1000000.0;
+      sumDisplayFreqTicks = 0;
+      sumDisplayTicks = 0;
     }
   } // band_LF
 
@@ -1386,14 +3375,16 @@ void Pandauino_Freq_LF_VHF::displayMeasurement() {
 	}
 
   switch (operation) {
-		case operation_none: resultFrequency = frequency; break; // No operation applied
-		case operation_vfo_plus: resultFrequency = frequency + refFrequency; break;
-		case operation_vfo_minus: resultFrequency = frequency - refFrequency; break;
-		case operation_if_minus: resultFrequency = refFrequency - frequency;
+		case operation_none: resultFrequency = frequencyMicroHertz; break; // No operation applied
+		case operation_vfo_plus: resultFrequency = frequencyMicroHertz + refFrequency; break;
+		case operation_vfo_minus: resultFrequency = frequencyMicroHertz - refFrequency; break;
+		case operation_if_minus: resultFrequency = refFrequency - frequencyMicroHertz;
 	}
 
 	// Used to store the ref frequency
-	lastValidFrequency = frequency;
+	lastValidFrequency = frequencyMicroHertz;
+
+	updateDrift();
 
   // display frequency or period
   if (measurementType == measure_frequency) displayFrequency();
@@ -1403,19 +3394,86 @@ void Pandauino_Freq_LF_VHF::displayMeasurement() {
 
 }
 
+//*********************************************************************************************************
+// Message hold
+// A message is kept on the LCD for a given time without blocking. Measurements are not displayed meanwhile
+// and the menu entry is printed again when the time is over.
+void Pandauino_Freq_LF_VHF::holdMessage(unsigned int holdTime) {
+	messageStamp = millis();
+	messageHoldTime = holdTime;
+}
+
+boolean Pandauino_Freq_LF_VHF::messageHeld() {
+	return ((messageHoldTime > 0) && ((millis() - messageStamp) < messageHoldTime));
+}
+
+void Pandauino_Freq_LF_VHF::releaseMessage() {
+	if ((messageHoldTime > 0) && !messageHeld()) {
+		messageHoldTime = 0;
+		if (editMode != display_main) printMenuEntry();
+	}
+}
+
+//*********************************************************************************************************
+// Prints the current menu entry unless a message is held
+void Pandauino_Freq_LF_VHF::printMenuEntry() {
+
+	if (messageHeld()) return;
+
+	// "Calibrating..." stays on the LCD until calibrationStep() ends
+	if ((state == state_calibration_skip) || (state == state_calibration_gate)) return;
+
+	if (editMode == display_calibration_manual_set) displayCalManValue();
+	else if ((editMode >= display_statistics_mean) && (editMode <= display_statistics_count)) displayStatistics();
+	else {
+		strcpy_P(line1, menuEntries[editMode]);
+		printSixteenCharToLCD(line1);
+	}
+
+}
+
 //*********************************************************************************************************
 // DisplayCalManValue
 // Displays a calibration value expressed in ppm
 void Pandauino_Freq_LF_VHF::displayCalManValue() {
 
-	text = "Cal: ";
-	dtostrf(calManValue, 3, 1, text1);
-  text.concat((String)text1);
-  text.concat(" ppm");
-  text.toCharArray(line1, 17);
+	byte position;
+
+	position = appendText(0, "Cal: ");
+	position = appendFixed(position, lround(calManValue * 10), 1);
+	position = appendText(position, " ppm");
+	endLine(position);
   printSixteenCharToLCD(line1);
 
 }
+//*********************************************************************************************************
+// DisplayStatistics
+// Displays one of the running statistics after the first 4 characters of its menu entry, e.g. "Avg 14.31818 MHz"
+// The measures are stopped in the menu, so the values stay still while they are read.
+void Pandauino_Freq_LF_VHF::displayStatistics() {
+
+	measurementStatistics statistics;
+	byte position = 0;
+
+	getStatistics(statistics);
+
+	while (position < 4) {
+		line1[position] = pgm_read_byte(&menuEntries[editMode][position]);
+		position++;
+	}
+
+	if (statistics.count == 0) position = appendText(position, "-");
+	else if (editMode == display_statistics_mean) position = appendMicroHertz(position, statistics.mean);
+	else if (editMode == display_statistics_deviation) position = (statistics.count > 1) ? appendMicroHertz(position, statistics.deviation) : appendText(position, "-");
+	else if (editMode == display_statistics_minimum) position = appendMicroHertz(position, statistics.minimum);
+	else if (editMode == display_statistics_maximum) position = appendMicroHertz(position, statistics.maximum);
+	else if (editMode == display_statistics_count) position = appendFixed(position, statistics.count, 0);
+
+	endLine(position);
+	printSixteenCharToLCD(line1);
+
+}
+
 //*********************************************************************************************************
 // EvaluateCalManValue
 // evaluates the calManValue (used of setting) depending on calibration value (stored and use globally)
@@ -1431,16 +3489,105 @@ void Pandauino_Freq_LF_VHF::evaluateCalManValue() {
 **************************************************************************************************************************************/
 
 //*********************************************************************************************************
-// Counts the number of digits of the integer part
-byte Pandauino_Freq_LF_VHF::countIntDigits(int num) {
+// Line formatting
+// The LCD lines are written straight into line1, without String.
+// Each function writes from position and returns the position following what it wrote. Nothing is written past 16 characters.
+
+byte Pandauino_Freq_LF_VHF::appendText(byte position, const char toAppend[]) {
+
+  while ((*toAppend != 0) && (position < 16)) line1[position++] = *toAppend++;
+  return position;
+}
+
+// Writes value / 10^decimals with the given number of decimals. Example: 14318, 3 --> 14.318
+byte Pandauino_Freq_LF_VHF::appendFixed(byte position, long value, byte decimals) {
+
+  char digits[11];
+  byte nbDigits = 0;
+  unsigned long absoluteValue = (value < 0) ? -value : value;
+
+  // digits from the lowest, with at least one before the point
+  do {
+    digits[nbDigits++] = '0' + absoluteValue % 10;
+    absoluteValue /= 10;
+  } while ((absoluteValue != 0) || (nbDigits <= decimals));
+
+  if (value < 0) position = appendText(position, "-");
+
+  while ((nbDigits > 0) && (position < 16)) {
+    if (nbDigits == decimals) line1[position++] = '.';
+    if (position < 16) line1[position++] = digits[--nbDigits];
+  }
+  return position;
+}
+
+// Writes a positive uHz value in Hz, KHz or MHz with as many decimals as the line can hold, down to the uHz. Example: 14318180000000 --> 14.31818 MHz
+byte Pandauino_Freq_LF_VHF::appendMicroHertz(byte position, int64_t value) {
+
+  int64_t unitValue;												// uHz in one displayed unit
+  int64_t roundingStep;
+  const char *unit;
+  byte maxDecimals;
+  byte nbOfIntDigits = 0;
+  byte nbOfDecimals = 0;
+  byte width;
+
+  if (value >= 1000000000000LL) {
+    unitValue = 1000000000000LL;
+    unit = " MHz";
+    maxDecimals = 12;
+  }
+  else if (value >= 1000000000LL) {
+    unitValue = 1000000000LL;
+    unit = " KHz";
+    maxDecimals = 9;
+  }
+  else {
+    unitValue = 1000000LL;
+    unit = " Hz";
+    maxDecimals = 6;
+  }
+
+  for (roundingStep = value / unitValue; roundingStep != 0; roundingStep /= 10) nbOfIntDigits++;
+  if (nbOfIntDigits == 0) nbOfIntDigits = 1;
+
+  // the integer digits, the point and the decimals in what is left before the unit
+  width = 16 - position - strlen(unit);
+  if (width > nbOfIntDigits + 1) nbOfDecimals = width - nbOfIntDigits - 1;
+  if (nbOfDecimals > maxDecimals) nbOfDecimals = maxDecimals;
+
+  roundingStep = unitValue;
+  for (byte i = 0; i < nbOfDecimals; i++) roundingStep /= 10;
+
+  position = appendFixed(position, (value + roundingStep / 2) / roundingStep, nbOfDecimals);
+  return appendText(position, unit);
+}
+
+// Fills the rest of line1 with spaces
+void Pandauino_Freq_LF_VHF::endLine(byte position) {
+
+  while (position < 16) line1[position++] = ' ';
+  line1[16] = 0;
+}
+
+//*********************************************************************************************************
+// Integer square root, rounded down, by the bit by bit method: no float nor libm
+uint32_t Pandauino_Freq_LF_VHF::squareRoot(uint64_t value) {
+
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
 
-  // counts the number of digits in a numbrer. Example: 123.34 --> 3
-  byte count = 0;
-  while (num) {
-    num = num / 10;
-    count++;
+  while (bit > value) bit >>= 2;
+
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else root >>= 1;
+    bit >>= 2;
   }
-  return count;
+  return root;
 }
 
 //*********************************************************************************************************
@@ -1461,6 +3608,43 @@ void Pandauino_Freq_LF_VHF::determineBand(float freq) {
 }
 
 
+//*********************************************************************************************************
+// Tests if a frequency is within the limits of a band widened by a margin in %
+boolean Pandauino_Freq_LF_VHF::frequencyInBand(double freq, measurementBand _band, float marginPerCent) {
+
+	double low = 0.0;
+	double high = 0.0;							// 0.0: no upper limit
+
+	switch (_band) {
+
+		case band_LF:
+			low = freqLFmin;
+			high = freqLFmax;
+			break;
+
+		case band_HF:
+			low = freqHFmin;
+			if (boardVersion == board_version_hf) high = freqHFmax_hf_board;
+			else high = freqHFmax_vhf_board;
+			break;
+
+		case band_VHF1:
+			low = freqVHF1min;
+			high = freqVHF1max;
+			break;
+
+		case band_VHF2:
+			low = freqVHF2min;
+			break;
+	}
+
+	low *= (100 - marginPerCent) / 100;
+	high *= (100 + marginPerCent) / 100;
+
+	return ((freq >= low) && ((high == 0.0) || (freq <= high)));
+
+}
+
 /* ************************************************************************************************************************************
   INTERFACE FUNCTIONS
 **************************************************************************************************************************************/
@@ -1469,13 +3653,13 @@ void Pandauino_Freq_LF_VHF::determineBand(float freq) {
 // Do all the actions after a user menu choice
 void Pandauino_Freq_LF_VHF::actions() {
 
-	previousMode = mode;
-	previousBand = band;
-	previousResolution = resolution;
-	previousCalibration = calibration;
-	previousMeasurementType = measurementType;
-	previousOperation = operation;
-	previousSleepSetting = sleepSetting;
+	measurementMode oldMode = mode;
+	measurementBand oldBand = band;
+	measurementResolution oldResolution = resolution;
+	double oldCalibration = calibration;
+	measurementDisplayType oldMeasurementType = measurementType;
+	operationType oldOperation = operation;
+	sleepMode oldSleepSetting = sleepSetting;
 
 	switch (editMode) {
 
@@ -1531,17 +3715,17 @@ void Pandauino_Freq_LF_VHF::actions() {
 		resolution = resolution_ultra_high;
 		break;
 
+		// the calibration runs with its own setup, set back and stored by endCalibration()
 		case display_calibration_4M:
 		calibrate(4000000);
-		break;
+		return;
 
 		case display_calibration_10M:
 		calibrate(10000000);
-		break;
+		return;
 
 		case display_calibration_manual_set:
 		calibration = (1000000.0 + calManValue) / 1000000.0;
-		updateToEEPROM_calibration();
 		break;
 
 		case display_frequency:
@@ -1554,16 +3738,15 @@ void Pandauino_Freq_LF_VHF::actions() {
 
 		case display_store:
 		refFrequency = lastValidFrequency;
-		updateToEEPROM_refFrequency();
+		settingsChanged();
 		printSixteenCharToLCD(const_cast<char*>(frequencySaved));
-		delay(2000);
+		holdMessage(2000);
 		break;
 
 		case display_retrieve:
-		readFromEEPROM_refFrequency();
 		resultFrequency = refFrequency;
 		displayFrequency();
-		delay(2000);
+		holdMessage(2000);
 		frequency = 0.0;
 		break;
 
@@ -1597,18 +3780,31 @@ void Pandauino_Freq_LF_VHF::actions() {
 		sleepSetting = sleep_disabled;
 		break;
 
+		case display_statistics_reset:
+		resetStatistics();
+		break;
+
 		case display_factory_reset:
-		EEPROM_writeAnything(EEPROMbaseAddress, eepromInit+1); // dummy value to force update EEPROM after reset
+		eraseSettings(); // the defaults are stored after reset
 		resetFunc();
+		break;
+
+		default:
+		break;
+	}
+
+	if (sleepSetting != oldSleepSetting) setSleepTimeout();
+
+	if ((mode != oldMode) || (band != oldBand) || (resolution != oldResolution) || (calibration != oldCalibration)
+			|| (measurementType != oldMeasurementType) || (operation != oldOperation) || (sleepSetting != oldSleepSetting)) {
+		settingsChanged();
 	}
 
-	if (mode != previousMode) updateToEEPROM_mode();
-	if (band != previousBand) updateToEEPROM_band();
-	if (resolution != previousResolution) updateToEEPROM_resolution();
-	if (calibration != previousCalibration) updateToEEPROM_calibration();
-	if (measurementType != previousMeasurementType) updateToEEPROM_measurementType();
-	if (operation != previousOperation) updateToEEPROM_operation();
-	if (sleepSetting != previousSleepSetting) { setSleepTimeout(); updateToEEPROM_sleepSetting();}
+	// the statistics are those of one measurement setup
+	if ((mode != oldMode) || (band != oldBand) || (resolution != oldResolution) || (calibration != oldCalibration)) {
+		resetStatistics();
+		resetDrift();
+	}
 
 }
 
@@ -1619,7 +3815,7 @@ void Pandauino_Freq_LF_VHF::actions() {
 
 // ************************************************************************************************************************************
 // Wake-up routine after sleep
-static void Pandauino_Freq_LF_VHF::pushButtonInterrupt()
+void Pandauino_Freq_LF_VHF::pushButtonInterrupt()
 {
   displayStamp = millis(); // to reset the energy economy timeout
 }
@@ -1635,15 +3831,17 @@ void Pandauino_Freq_LF_VHF::buttonPress() {
   if (editMode == display_main) {
     editMode = display_freq_band;
 		stopComputation();
-    printSixteenCharToLCD(menuEntries[editMode]);
-		delay(500);
+    printMenuEntry();
+		holdMessage(500);
 		return;
 	// Exiting the menu
   } else if (editMode == display_exit_menu) {
     editMode = display_main;
     displayStamp = millis(); // to avoid going to sleep after a long usage of the menu
     configureComputation(true);
-    printSixteenCharToLCD(menuEntries[editMode]);
+    messageHoldTime = 0;
+    strcpy_P(line1, menuEntries[editMode]);
+    printSixteenCharToLCD(line1);
 		return;
 	}
 
@@ -1654,8 +3852,9 @@ void Pandauino_Freq_LF_VHF::buttonPress() {
 	if ((editMode == display_frequency) || (editMode == display_period)){ editMode = display_fp; treated = true;}
 	if ((editMode == display_operation_annul) || (editMode == display_operation_vfo_plus) ||  (editMode == display_operation_vfo_minus) || (editMode == display_operation_if_minus) ){ editMode = display_operation; treated = true;}
 	if ((editMode == display_sleep_30s) || (editMode == display_sleep_5m) || (editMode == display_sleep_disabled)){ editMode = display_sleep; treated = true;}
+	if ((editMode >= display_statistics_mean) && (editMode <= display_statistics_reset)){ editMode = display_statistics; treated = true;}
 
-	if (treated == true){  printSixteenCharToLCD(menuEntries[editMode]); return;}
+	if (treated == true){  printMenuEntry(); return;}
 
 	// Moves down the menu tree
 	switch (editMode) {
@@ -1683,7 +3882,6 @@ void Pandauino_Freq_LF_VHF::buttonPress() {
 		case display_calibration_manual:
 		editMode = display_calibration_manual_set;
 		evaluateCalManValue();
-		displayCalManValue();
 		break;
 
 		case display_fp:
@@ -1702,14 +3900,17 @@ void Pandauino_Freq_LF_VHF::buttonPress() {
 		if (sleepSetting == sleep_30s) editMode = display_sleep_30s;
 		if (sleepSetting == sleep_5m) editMode = display_sleep_5m;
 		if (sleepSetting == sleep_disabled) editMode = display_sleep_disabled;
+		break;
 
-	}
+		case display_statistics: editMode = display_statistics_mean; break;
+
+		default: break;
 
- 	if (editMode != display_calibration_manual_set) {
- 		printSixteenCharToLCD(menuEntries[editMode]);
- 		delay(500);
 	}
 
+ 	printMenuEntry();
+ 	if (editMode != display_calibration_manual_set) holdMessage(500);
+
 }
 
 //*********************************************************************************************************
@@ -1747,6 +3948,10 @@ void Pandauino_Freq_LF_VHF::buttonClick() {
 		break;
 
 		case display_sleep:
+		editMode = display_statistics;
+		break;
+
+		case display_statistics:
 		editMode = display_factory_reset;
 		break;
 
@@ -1818,7 +4023,6 @@ void Pandauino_Freq_LF_VHF::buttonClick() {
 		case display_calibration_manual_set:
 		calManValue +=0.5;
 		if (calManValue >= maxCalibManValue) calManValue = minCalibManValue;
-		displayCalManValue();
 		break;
 
 		case display_frequency:
@@ -1856,12 +4060,37 @@ void Pandauino_Freq_LF_VHF::buttonClick() {
 		case display_sleep_disabled:
 		editMode = display_sleep_30s;
 		break;
-	}
 
- 	if (editMode != display_calibration_manual_set) {
- 		printSixteenCharToLCD(menuEntries[editMode]);
+		case display_statistics_mean:
+		editMode = display_statistics_deviation;
+		break;
+
+		case display_statistics_deviation:
+		editMode = display_statistics_minimum;
+		break;
+
+		case display_statistics_minimum:
+		editMode = display_statistics_maximum;
+		break;
+
+		case display_statistics_maximum:
+		editMode = display_statistics_count;
+		break;
+
+		case display_statistics_count:
+		editMode = display_statistics_reset;
+		break;
+
+		case display_statistics_reset:
+		editMode = display_statistics_mean;
+		break;
+
+		default:
+		break;
 	}
 
+ 	printMenuEntry();
+
 }
 
 Pandauino_Freq_LF_VHF frequencyCounter;
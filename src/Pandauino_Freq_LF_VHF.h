@@ -19,8 +19,13 @@
  *
  *  ** Matthias Hertel One Button library http://www.mathertel.de/Arduino/OneButtonLibrary.aspx
  *
+ *  ** Wire library included in the Arduino core, for the I2C slave mode. Only used when the library is built with -DFREQ_ENABLE_I2C
+ *
  *  ** power & sleep libraries included in Arduino/avr core
  *
+ *  All of them are reached through the hardware abstraction layer Pandauino_Freq_LF_VHF_HAL.h.
+ *  Outside of the Arduino environment a simulated backend (sim/Pandauino_Freq_LF_VHF_sim.h) replaces them.
+ *
  *  This code is based on Arduino code and is provided with the same warning that:
  *  THIS SOFTWARE IS PROVIDED TO YOU "AS IS" AND WE MAKE NO EXPRESS OR IMPLIED WARRANTIES WHATSOEVER WITH RESPECT TO ITS FUNCTIONALITY, OPERABILITY, OR USE,
  *  INCLUDING, WITHOUT LIMITATION, ANY IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR INFRINGEMENT.
@@ -74,6 +79,14 @@
   	Sleep 5 m.
   	Sleep disabled
 
+  Statistics     >
+  	Avg mean value
+  	Dev standard deviation
+  	Min minimum value
+  	Max maximum value
+  	N   number of measures
+  	Reset (press)
+
 	F. reset (press)
 
   < Exit menu
@@ -84,14 +97,7 @@
 #ifndef Pandauino_Freq_LF_VHF_h
 #define Pandauino_Freq_LF_VHF_h
 
-#include <Arduino.h>
-#include <EEPROM.h>
-#include <FreqCount.h>
-#include <FreqMeasure.h>
-#include <LiquidCrystal.h>
-#include <OneButton.h>
-#include <avr/power.h>
-#include <avr/sleep.h>
+#include "Pandauino_Freq_LF_VHF_HAL.h"
 
 
 /* ************************************************************************************************************************************
@@ -166,6 +172,14 @@ enum runMode {
 	display_sleep_5m,
 	display_sleep_disabled,
 
+	display_statistics,
+	display_statistics_mean,
+	display_statistics_deviation,
+	display_statistics_minimum,
+	display_statistics_maximum,
+	display_statistics_count,
+	display_statistics_reset,
+
 	display_factory_reset,
 
 	display_exit_menu
@@ -210,9 +224,142 @@ enum sleepMode {
 };
 
 
+enum counterState {
+	state_measure,
+	state_search_probe_settle,
+	state_search_probe,
+	state_search_gate_settle,
+	state_search_gate,
+	state_calibration_skip,
+	state_calibration_gate,
+	state_standby_message,
+	state_standby_off,
+	state_wake_up,
+	state_voltage_error
+};
+
 enum algorithmType {
 	algorithm_freqMeasure,
-	algorithm_freqCount
+	algorithm_freqCount,
+	algorithm_reciprocal
+};
+
+enum gateMode {
+	gate_fixed,					// One gate time, set by the resolution
+	gate_stacked,				// 10 ms gates summed into 100 ms, 1 s and 10 s results, see stackGate()
+	gate_adaptive				// The shortest gate giving the digits of the resolution at the frequency measured, see computeAdaptiveGate()
+};
+
+enum estimatorType {
+	estimator_mean,				// LF: the time of the periods captured over their number, i.e. from the first and last edges
+	estimator_regression	// LF: least squares line through the times of all the edges captured, see regressionStep()
+};
+
+enum serialFormat {
+	serial_ascii,				// Serial.println() of the displayed value, at the LCD refresh rate
+	serial_binary				// One binary frame per measurement, see sendBinaryFrame()
+};
+
+// Register map of the I2C slave mode, see beginI2C() (library built with -DFREQ_ENABLE_I2C). Multi bytes values are little endian
+enum i2cRegister {
+	i2c_status = 0x00,				// i2cStatusFlag bits
+	i2c_mode = 0x01,					// measurementMode
+	i2c_band = 0x02,					// measurementBand
+	i2c_resolution = 0x03,		// measurementResolution
+	i2c_algorithm = 0x04,			// algorithmType
+	i2c_gate_mode = 0x05,			// gateMode
+	i2c_sequence = 0x06,			// 2 bytes, incremented on every new measurement
+	i2c_frequency = 0x08,			// 8 bytes, signed, last measurement (uHz)
+	i2c_timestamp = 0x10,			// 4 bytes, millis() of the last measurement
+	i2c_gate_time = 0x14,			// 4 bytes, time span of the last measurement (us)
+	i2c_raw_count = 0x18,			// 4 bytes, counter value of the last measurement
+	i2c_overflows = 0x1C,			// 4 bytes, measurements lost because the FIFO was full
+	i2c_fifo_count = 0x20,		// measurements waiting in the FIFO
+	i2c_control = 0x21,				// mode (bit 0), band (bits 1-2), resolution (bits 3-4). Writing it with i2c_control_apply applies them
+	i2c_fifo_data = 0x22,			// reading it removes the oldest measurement from the FIFO, see i2cRequest()
+	i2c_adev_gate = 0x24,			// 4 bytes, gate time of the Allan deviation samples, tau0 (us). The i2c_adev registers are 0 without -DFREQ_ENABLE_ADEV
+	i2c_adev_samples = 0x28,	// 4 bytes, gate results in the Allan deviation since its restart
+	i2c_adev = 0x2C,					// 5 x 4 bytes, overlapping Allan deviation at tau0 x 1, 2, 4, 8, 16 in 1E-12, up to ALLAN_OCTAVES. 0 when not available
+	i2c_drift = 0x40,					// 4 bytes, signed, drift rate of the displayed frequency (uHz/s)
+	i2c_settled = 0x44,				// 1 when the drift rate stayed under the settling threshold for the settling time, see setSettling()
+	i2c_register_end = 0x45
+};
+
+enum i2cStatusFlag {
+	i2c_status_valid = 0x01,						// a measurement is available
+	i2c_status_searching = 0x02,				// auto mode band search
+	i2c_status_calibrating = 0x04,
+	i2c_status_standby = 0x08,
+	i2c_status_voltage_error = 0x10,
+	i2c_status_menu = 0x20,							// the user is in the menu
+	i2c_status_fifo_overflow = 0x40,		// measurements were lost
+	i2c_status_control_pending = 0x80		// a control write is waiting to be applied by freqCount()
+};
+
+#define i2c_control_apply 0x80
+
+enum disciplineState {
+	discipline_off,							// no 1 PPS input
+	discipline_acquiring,				// estimating the timebase error, calibration is not changed
+	discipline_locked,					// the estimate is stable and applied to calibration
+	discipline_holdover					// the pulses stopped: the last estimate stays applied
+};
+
+/* ************************************************************************************************************************************
+  STRUCT
+**************************************************************************************************************************************/
+
+// A measurement as stored in the measurement ring buffer
+struct measurementRecord {
+	unsigned long timestamp;		// millis() when the measure was done
+	byte band;									// measurementBand
+	unsigned long rawCount;			// edges in gated counting, 16 MHz clock ticks in input capture
+	unsigned long gateTime;			// time span of the measure (us)
+	int64_t value;							// calibrated frequency (uHz)
+};
+
+// Number of records of the measurement ring buffer, one of them being kept free. USE A POWER OF 2 <= 128
+// Each one takes 19 bytes of SRAM: raise it by a build flag (-DMEASUREMENT_RING_SIZE=16) when the sketch drains the measurements in bursts
+#ifndef MEASUREMENT_RING_SIZE
+#define MEASUREMENT_RING_SIZE 4
+#endif
+
+// A measurement as kept in the ring buffer. The value is stored on 48 bits: 210 MHz is 2.1E14 uHz < 2^48
+struct storedMeasurement {
+	unsigned long timestamp;
+	byte band;
+	unsigned long rawCount;
+	unsigned long gateTime;
+	uint32_t valueLow;					// bits 0 to 31 of the value (uHz)
+	uint16_t valueHigh;					// bits 32 to 47
+};
+
+// The filters applied to the measures of a band, in this order, see filterMeasurement()
+struct filterSettings {
+	unsigned long glitchPpm;		// a measure further than this from lastValidFrequency is rejected, 0 = off
+	byte median;								// running median of this number of measures, 1 = off, at most FILTER_MEDIAN_SIZE
+	byte emaAlpha;							// exponential moving average, weight of a new measure in 1/256, 0 = off
+};
+
+#define FILTER_MEDIAN_SIZE 7				// Longest running median
+
+// Allan deviation at tau = 1, 2, 4 and 8 gates, only built with -DFREQ_ENABLE_ADEV. At most 5, the octaves of the i2c_adev registers.
+// Each octave takes 17 bytes of SRAM and doubles the gate results kept, 4 bytes each: raise it by a build flag (-DALLAN_OCTAVES=5) for tau = 16 gates
+#ifndef ALLAN_OCTAVES
+#define ALLAN_OCTAVES 4
+#endif
+#define ALLAN_HISTORY (1 << ALLAN_OCTAVES)		// Gate results kept, 2 x 2^(ALLAN_OCTAVES - 1)
+#if ALLAN_OCTAVES > 5
+#error "ALLAN_OCTAVES above 5 does not fit the i2c_adev registers"
+#endif
+
+// Running statistics of the measures displayed since resetStatistics(), see getStatistics()
+struct measurementStatistics {
+	unsigned long count;				// number of measures
+	int64_t minimum;						// uHz
+	int64_t maximum;						// uHz
+	int64_t mean;								// uHz
+	int64_t deviation;					// sample standard deviation (uHz), 0 below 2 measures
 };
 
 /* ************************************************************************************************************************************
@@ -233,12 +380,51 @@ class Pandauino_Freq_LF_VHF {
     static void freqSetup(boardType, bool _outPutToSerial = false, long _bauds = 57600);
     static void freqCount();
     static double getFrequency();
+    static int64_t getFrequencyMicroHertz();
     static double readFrequency();
+    static byte measurementsAvailable();
+    static byte readMeasurements(measurementRecord[], byte);
+    static unsigned long getMeasurementOverflows();
+    static void setBandTracking(bool);
+    static void setReciprocalCounting(bool);
+    static void setSerialFormat(serialFormat);
+    static void setContinuousGating(bool);
+    static void setGateMode(gateMode);
+    static void setStackPublish(byte);
+    static void setLFEstimator(estimatorType);
+    static void setFilter(measurementBand, byte median, byte emaAlpha, unsigned long glitchPpm);
+    static unsigned long getFilterRejects();
+    static void resetStatistics();
+    static void getStatistics(measurementStatistics &);
+    static double getStackedFrequency(measurementResolution);
+    static unsigned long getGatesLost();
+    static unsigned long getCapturesLost();
+    static byte getCaptureBacklog();
+#ifdef FREQ_ENABLE_I2C
+    static void beginI2C(byte address = 8);
+    static void endI2C();
+#endif
+#ifdef FREQ_PPS_ON_PCINT0
+    static void beginDiscipline(byte pin = 12);
+    static void endDiscipline();
+#endif
+    static disciplineState getDisciplineState();
+    static long getTimebaseErrorPpb();
+#ifdef FREQ_ENABLE_ADEV
+    static void setAllanDeviation(bool, bool printToSerial = false);
+    static double getAllanDeviation(byte);
+    static double getAllanTau(byte);
+#endif
+    static void setSettling(double, unsigned long, bool printToSerial = false);
+    static double getDriftRate();
+    static bool isSettled();
 
     static void standbyMode();
     static void beginSerial(long);
     static void endSerial();
     static void calibrate(long);
+    static void calibrateAll(long);
+    static double getBandCalibration(measurementBand);
 
  		static sleepMode sleepSetting;
    	static double calibration;
@@ -249,21 +435,74 @@ class Pandauino_Freq_LF_VHF {
 
 		// ******* FUNCTIONS
     static void configureComputation(bool restart = false);
-		static double measureLF();
-		static double measureHF_VHF();
-
-		static void readAllFromEEPROM();
-		static void readFromEEPROM_refFrequency();
-		static void updateToEEPROM_init();
-		static void updateToEEPROM_mode();
-		static void updateToEEPROM_band();
-		static void updateToEEPROM_resolution();
-		static void updateToEEPROM_calibration();
-		static void updateToEEPROM_measurementType();
-		static void updateToEEPROM_operation();
-		static void updateToEEPROM_sleepSetting();
-		static void updateToEEPROM_refFrequency();
-		static void updateAllToEEPROM();
+		static int64_t measureLF();
+		static int64_t measureHF_VHF();
+		static int64_t measureReciprocal();
+		static void configureMultipliers();
+		static int64_t applyCalibration(int64_t);
+		static unsigned int computeReciprocalPeriods(double);
+		static float computeAdaptiveGate(double);
+		static unsigned int computeLFPeriods(double);
+		static unsigned long computeLFTimeout();
+		static void sizeLFCapture(unsigned int);
+		static int64_t regressionStep(unsigned long);
+		static void resetRegression();
+		static void switchHFAlgorithm(algorithmType);
+		static void startProbe();
+		static double measureProbe();
+
+		static void searchStep();
+		static void beginCalibration(long);
+		static bool nextCalibrationBand();
+		static void startCalibration();
+		static void calibrationStep();
+		static void endCalibration();
+		static void standbyStep();
+
+		static void newMeasurement(int64_t);
+		static int64_t filterMeasurement(int64_t);
+		static void resetFilter();
+		static void updateStatistics(int64_t);
+		static void publishMeasurement(int64_t);
+		static void pushMeasurement(int64_t);
+		static void sendBinaryFrame(int64_t);
+		static void serialPrintMicroHertz(int64_t);
+		static void stackGate();
+		static void resetStack();
+		static byte putBytes(byte[], byte, unsigned long, byte);
+		static unsigned long getBytes(const byte[], byte, byte);
+		static uint16_t crc16Update(uint16_t, byte);
+
+#ifdef FREQ_ENABLE_I2C
+		static void i2cReceive(int);
+		static void i2cRequest();
+		static void serviceI2C();
+		static byte i2cStatus();
+		static void updateI2CSnapshot(bool, int64_t);
+#endif
+
+		static void loadSettings();
+		static void readLegacySettings();
+		static void readSettingsRecord(int);
+		static byte checkedSetting(int, byte, byte);
+		static long checkedCalibrationPpb(long);
+		static byte settingsRecordLengthOf();
+		static void settingsChanged();
+		static void settingsStep();
+		static void eraseSettings();
+
+		static void ppsInterrupt(unsigned long);
+		static void disciplineStep();
+		static void filterDiscipline(long);
+
+#ifdef FREQ_ENABLE_ADEV
+		static void allanSample(int64_t);
+		static void allanStep();
+		static void resetAllan();
+		static void serialPrintAllan(byte);
+#endif
+		static void updateDrift();
+		static void resetDrift();
 
 		static void (* resetFunc)();
 
@@ -272,20 +511,31 @@ class Pandauino_Freq_LF_VHF {
  		static void initVcc();
 		static float readVcc();
     static void VccTest();
+    static void VccCheck();
     static bool timeToTestVCC();
 
-    static void sixteenTo8chars (char[], char[], char[] );
-    static void printSixteenCharToLCD (char[]);
+    static void printSixteenCharToLCD (const char[]);
+    static void invalidateLCDShadow();
     static void displayFrequency();
     static void displayPeriod();
 
 		static boolean testFrequencyOutOfRange();
     static void displayMeasurement();
+		static void holdMessage(unsigned int);
+		static boolean messageHeld();
+		static void releaseMessage();
+		static void printMenuEntry();
 		static void displayCalManValue();
+		static void displayStatistics();
 		static void evaluateCalManValue();
 
-		static byte countIntDigits(int);
+		static byte appendText(byte, const char[]);
+		static byte appendFixed(byte, long, byte);
+		static byte appendMicroHertz(byte, int64_t);
+		static void endLine(byte);
+		static uint32_t squareRoot(uint64_t);
 		static void determineBand(float);
+		static boolean frequencyInBand(double, measurementBand, float);
 
     static void pushButtonInterrupt();
     static void actions();
@@ -335,21 +585,72 @@ class Pandauino_Freq_LF_VHF {
 		static const char goingStandby[17];
 		static const char frequencySaved[17];
 		static const char frequencyOutOfRange[17];
-		static const char menuEntries[34][17];
-
-  	static const byte EEPROMbaseAddress;
-		static const byte eepromInit;
+		static const char menuEntries[][17];
+
+		static const byte settingsVersion;
+		static const byte settingsRecordLength;
+		static const byte settingsSlotSize;
+		static const unsigned int settingsFlushDelay;
+		static const byte legacyEepromInit;
+		static const long maxStoredCalibrationPpb;
+
+		static const byte ppsBlockLength;
+		static const long ppsTolerance;
+		static const unsigned int ppsTimeout;
+		static const byte disciplineFilterShift;
+		static const long disciplineLockPpb;
+		static const byte disciplineLockBlocks;
+
+#ifdef FREQ_ENABLE_ADEV
+		static const unsigned int allanReportPeriod;
+		static const byte allanLineLength;
+#endif
+		static const unsigned int driftInterval;
+		static const byte driftFilterShift;
+		static const byte driftLineLength;
 
     static const float HFMeasurePeriodNormalRes;
-    static const unsigned int LFTimeoutNormalRes ;
+    static const float stackedTimeCoefficient;
+    static const byte multiplierShift;
+    static const unsigned int HFProbePeriod;
+    static const float bandHysteresisPerCent;
+    static const double reciprocalMaxFrequency;
+    static const byte reciprocalGateDivider;
+    static const unsigned int reciprocalMaxPeriods;
+    static const unsigned int adaptiveGateMin;
+    static const unsigned int adaptiveGateMax;
+    static const float adaptiveGateMargin;
+    static const unsigned long bandVerifyPeriod;
+    static const float LFMeasurePeriodNormalRes;
+    static const unsigned int LFMaxPeriods;
+    static const unsigned int LFTimeoutMargin;
+    static const unsigned int LFTimeoutMax;
+    static const byte captureBufferCapacity;
+    static const unsigned int regressionCaptureTime;
+    static const unsigned int regressionMaxCaptures;
+    static const byte regressionShift;
+    static const byte filterGlitchRejects;
+    static const byte statisticsMeanShift;
     static const unsigned int  displayTimeLap;
 
+    static const byte frameSync1;
+    static const byte frameSync2;
+    static const byte frameLength;
+#ifdef FREQ_ENABLE_I2C
+    static const byte i2cRecordLength;
+#endif
+
     static const float VccDivider ;
     static const float vref ;
     static const float coefVcc ;
     static const unsigned int VccTestPeriod ;
    static const unsigned int  vccDelayPeriod ;
 
+    static const unsigned int prescalerSettleDelay;
+    static const unsigned int standbyMessageTime;
+    static const unsigned int standbyPowerOffTime;
+    static const unsigned int wakeUpTime;
+
     static const float underVoltage;
     static const float overVoltage ;
     static const float hysteresisVccPerCent ;
@@ -371,39 +672,109 @@ class Pandauino_Freq_LF_VHF {
     static byte displayPrecision;
 		static float measurementTimeCoefficient;
 		static algorithmType algorithm;
+		static int64_t countMultiplier;
+		static int64_t periodNumerator;
+		static long calibrationPpb;
+		static long bandCalibrationPpb[4];
 		static float prescalerCoef;
 		static float effectiveHFMeasurePeriod;
-		static int LFTimeout;
+		static unsigned long LFTimeout;
+		static double LFEstimate;
+		static estimatorType estimator;
+		static unsigned int regressionCaptures;
+		static unsigned int regressionIndex;
+		static unsigned long regressionTime;
+		static int64_t regressionSumY;
+		static int64_t regressionSumXY;
+		static bool reciprocalCounting;
+		static double reciprocalEstimate;
+		static double adaptiveEstimate;
+		static unsigned int reciprocalPeriods;
+		static bool bandTracking;
+		static bool continuousGating;
+		static unsigned long gateStamp;
+		static unsigned long gatesLost;
+		static unsigned long captureStamp;
+		static long captureSlack;
+		static unsigned long capturesLost;
+		static byte captureBacklog;
+		static gateMode gating;
+		static unsigned long stackSum[3];
+		static byte stackGates[3];
+		static int64_t stackedFrequency[4];
+		static byte stackPublished;
+		static bool bandLocked;
+		static unsigned long bandLockStamp;
+
+		static counterState state;
+		static unsigned long stateStamp;
+		static long calibrationFrequency;
+		static bool calibratingAll;
+		static byte calibrationBands;
+		static unsigned long calibrationTimeout;
+		static unsigned long messageStamp;
+		static unsigned int messageHoldTime;
 
 		static measurementMode previousMode;
 		static measurementBand previousBand;
 		static measurementResolution previousResolution;
-		static double previousCalibration;
-		static measurementDisplayType previousMeasurementType;
-		static operationType previousOperation;
-		static sleepMode previousSleepSetting;
+		static gateMode previousGating;
+		static estimatorType previousEstimator;
 
     static unsigned long countLF;
     static unsigned long countHF;
     static unsigned long measureStamp;
     static unsigned long displayStamp;
 
-    static double sumDisplayFreq;
-    static long nbAvgDisplayFreq;
+    static int64_t sumDisplayFreqTicks;
+    static unsigned long sumDisplayTicks;
 
     static double frequency;
+    static int64_t frequencyMicroHertz;
+
+    static storedMeasurement measurementRing[MEASUREMENT_RING_SIZE];
+    static volatile byte ringHead;
+    static volatile byte ringTail;
+    static unsigned long ringOverflows;
+
+		static filterSettings bandFilter[4];
+		static int64_t filterHistory[FILTER_MEDIAN_SIZE];
+		static measurementBand filterBand;
+		static byte filterCount;
+		static byte filterIndex;
+		static int64_t filterAverage;
+		static byte glitchRejects;
+		static unsigned long filterRejects;
+
+		static unsigned long statisticsCount;
+		static int64_t statisticsMinimum;
+		static int64_t statisticsMaximum;
+		static int64_t statisticsMean;
+		static uint64_t statisticsM2;
+		static byte statisticsShift;
+
     static double frequencyTestVHF2;
-    static double frequencyTestVHF1;
-    static double frequencyTestHF;
-    static double frequencyTest;
+    static int64_t frequencyTest;
 
 		static  operationType operation;
-    static double lastValidFrequency;
-    static double refFrequency;
-    static double resultFrequency;
+    static int64_t lastValidFrequency;
+    static int64_t refFrequency;
+    static int64_t resultFrequency;
 
     static bool outputToSerial;
     static long bauds ;
+    static serialFormat outputFormat;
+    static unsigned int measurementSequence;
+    static unsigned long rawCount;
+    static unsigned long gateTime;
+    static byte frame[26];
+
+#ifdef FREQ_ENABLE_I2C
+    static byte i2cAddress;
+    static byte i2cSnapshot[i2c_register_end];
+    static volatile byte i2cPointer;
+    static volatile byte i2cControl;
+#endif
 
 		static float calManValue;
 
@@ -414,18 +785,55 @@ class Pandauino_Freq_LF_VHF {
 
 	  static unsigned long sleepTimeout;
 
-		static byte addressOfMode;
-		static byte addressOfBand;
-		static byte addressOfResolution;
-		static byte addressOfCalibration;
-		static byte addressOfMeasurementType;
-		static byte addressOfOperation;
-		static byte addressOfSleepSetting;
-		static byte addressOfRefFrequency;
-
-    static char text1[17] ;
-    static String text ;
+		static byte settingsBuffer[41];
+		static byte settingsSlot;
+		static unsigned long settingsSequence;
+		static byte settingsWriteIndex;
+		static bool settingsDirty;
+		static unsigned long settingsStamp;
+
+		static disciplineState discipline;
+		static volatile unsigned long ppsStamp;
+		static volatile byte ppsCount;
+		static byte ppsLastCount;
+		static unsigned long ppsLastStamp;
+		static unsigned long ppsBlockStamp;
+		static bool ppsBlockValid;
+		static byte ppsBlockCount;
+		static unsigned long ppsMillis;
+		static long disciplineAccumulator;
+		static long disciplinePpb;
+		static byte disciplineBlocks;
+		static byte lockCount;
+
+#ifdef FREQ_ENABLE_ADEV
+		static bool allanEnabled;
+		static bool allanPrint;
+		static long allanHistory[ALLAN_HISTORY];
+		static byte allanIndex;
+		static unsigned long allanCount;
+		static int64_t allanReference;
+		static unsigned long allanGateTime;
+		static uint64_t allanSum[ALLAN_OCTAVES];
+		static byte allanShift[ALLAN_OCTAVES];
+		static unsigned long allanValue[ALLAN_OCTAVES];
+		static byte allanReportOctave;
+		static unsigned long allanReportStamp;
+		static unsigned long allanReportedCount;
+#endif
+
+		static unsigned long settleMaxDrift;
+		static unsigned long settleTime;
+		static bool settlePrint;
+		static int64_t driftFrequency;
+		static unsigned long driftStamp;
+		static int64_t driftRate;
+		static bool driftValid;
+		static unsigned long settledStamp;
+		static bool settled;
+
     static char line1[17];
+    static char lcdShadow[16];
 
 };
 
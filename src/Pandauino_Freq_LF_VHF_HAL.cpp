@@ -0,0 +1,46 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Hardware abstraction layer: the functions needing an interrupt vector
+ *
+ *  See Pandauino_Freq_LF_VHF_HAL.h. The PCINT0 vector is only defined when the library is built with -DFREQ_PPS_ON_PCINT0
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#if defined(ARDUINO) && defined(FREQ_PPS_ON_PCINT0)
+
+#include "Pandauino_Freq_LF_VHF_HAL.h"
+
+static void (*ppsHandler)(unsigned long) = 0;
+static byte ppsMask = 0;
+
+//*********************************************************************************************************
+// 1 PPS input
+void halBeginPPS(byte pin, void (*handler)(unsigned long)) {
+
+  if ((pin < 11) || (pin > 13)) return;
+
+  pinMode(pin, INPUT);
+  ppsHandler = handler;
+  ppsMask = digitalPinToBitMask(pin);
+
+  PCMSK0 = ppsMask;                 // only this pin of port B
+  PCIFR = _BV(PCIF0);               // clears a pending change
+  PCICR |= _BV(PCIE0);
+}
+
+void halEndPPS() {
+  PCICR &= ~_BV(PCIE0);
+  PCMSK0 = 0;
+  ppsHandler = 0;
+}
+
+// Pin change interrupt of port B: any change, only the rising edge is kept
+ISR(PCINT0_vect) {
+
+  unsigned long stamp = micros();
+
+  if ((PINB & ppsMask) && ppsHandler) ppsHandler(stamp);
+}
+
+#endif // ARDUINO && FREQ_PPS_ON_PCINT0
@@ -0,0 +1,87 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Hardware abstraction layer
+ *
+ *  The library only talks to the hardware through:
+ *
+ *  ** the Arduino core functions (millis(), delay(), pinMode(), digitalWrite(), attachInterrupt()...) and Serial
+ *
+ *  ** the FreqCount, FreqMeasure, LiquidCrystal, EEPROM and OneButton libraries, and Wire when built with -DFREQ_ENABLE_I2C
+ *
+ *  ** the few hal...() functions below that replace direct AVR register accesses.
+ *     Those that need an interrupt vector are in Pandauino_Freq_LF_VHF_HAL.cpp
+ *
+ *  When compiled by the Arduino environment (ARDUINO defined) these are the real core and libraries.
+ *  Otherwise they are provided by the simulated backend in sim/Pandauino_Freq_LF_VHF_sim.h
+ *  so the whole library can run on a Linux host.
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#ifndef Pandauino_Freq_LF_VHF_HAL_h
+#define Pandauino_Freq_LF_VHF_HAL_h
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <FreqCount.h>
+#include <FreqMeasure.h>
+#include <LiquidCrystal.h>
+#include <OneButton.h>
+#ifdef FREQ_ENABLE_I2C
+#include <Wire.h>
+#endif
+#include <avr/power.h>
+#include <avr/sleep.h>
+
+//*********************************************************************************************************
+// ADC used to measure the board power voltage
+// initializes the ADC: clock prescaler 128, Ref AVCC, input ADC7
+inline void halInitAdc() {
+  ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) |(1<<ADPS0) ;
+  ADMUX =  (1<<REFS0) | 0x07; // Ref AVCC, input ADC7
+}
+
+inline void halAdcPower(bool on) {
+  if (on) power_adc_enable();
+  else power_adc_disable();
+}
+
+// gives the raw value of one conversion
+inline unsigned int halReadAdc() {
+
+  ADCSRA |= _BV(ADEN); 								// Start ADC
+  delay(2); 													// Wait for Vref to settle
+  ADCSRA |= _BV(ADSC); 								// Start conversion
+  while (bit_is_set(ADCSRA, ADSC)); 	// measuring
+
+  uint8_t low  = ADCL; // must read ADCL first - it then locks ADCH
+  uint8_t high = ADCH; // unlocks both
+
+  return (high << 8) | low;
+}
+
+//*********************************************************************************************************
+// Places the MCU in power down mode. Returns when woken up by an interrupt
+inline void halPowerDown() {
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_mode();
+}
+
+//*********************************************************************************************************
+// 1 PPS input on D11, D12 or D13 (PB3 to PB5) through the PCINT0 pin change interrupt.
+// handler is called on each rising edge with micros() read at the start of the interrupt.
+// Only built with -DFREQ_PPS_ON_PCINT0: the PCINT0 vector is then taken and cannot be used by another library such as SoftwareSerial.
+#ifdef FREQ_PPS_ON_PCINT0
+void halBeginPPS(byte pin, void (*handler)(unsigned long));
+void halEndPPS();
+#endif
+
+#else
+
+#include "sim/Pandauino_Freq_LF_VHF_sim.h"
+
+#endif
+
+#endif
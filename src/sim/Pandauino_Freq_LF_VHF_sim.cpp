@@ -0,0 +1,554 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Simulated backend of the hardware abstraction layer
+ *
+ *  See Pandauino_Freq_LF_VHF_sim.h
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#ifndef ARDUINO
+
+#include "Pandauino_Freq_LF_VHF_sim.h"
+
+/* ************************************************************************************************************************************
+  SIMULATED BOARD
+**************************************************************************************************************************************/
+
+//*********** Board wiring, as in Pandauino_Freq_LF_VHF.cpp
+static const uint8_t select1Pin = 15;
+static const uint8_t select2Pin = 14;
+static const uint8_t nbPins = 20;
+
+//*********** Board limits
+static const double counterMaxFrequency = F_CPU / 2.5;       // Highest frequency the synchronous T1 counter input can follow. Above, edges are missed.
+static const double captureMaxFrequency = 200000.0;          // Highest frequency the input capture interrupt can follow. Above, no capture is done.
+static const double vccDivider = 10.0 / 30.0;                // Resistor network divider of board VCC to ADC7
+static const double vref = 5.0;                              // ADC Reference voltage
+static const uint8_t captureBufferLength = 12;               // As FREQMEASURE_BUFFER_LEN
+
+//*********** Clock and signal
+static double simTime = 0.0;                                 // Virtual time of the MCU in seconds
+static double signalFrequency = 0.0;
+static double pathError[4] = {0.0, 0.0, 0.0, 0.0};           // ppm
+static double crystalError = 0.0;                            // ppm
+static float vcc = 9.0;
+static uint8_t pins[nbPins];
+
+//*********** T1 counter (FreqCount)
+static double t1Edges = 0.5;                                 // Cumulative edges seen by the T1 input
+static bool countRunning = false;
+static double gatePeriod = 0.0;
+static double gateEnd = 0.0;
+static double gateStartEdges = 0.0;
+static uint32_t countOutput = 0;
+static bool countReady = false;
+
+//*********** Input capture (FreqMeasure)
+static double icpEdges = 0.5;                                // Cumulative edges seen by the input capture
+static bool captureRunning = false;
+static uint32_t capturePeriods = 1;
+static double nextCaptureEdge = 0.0;
+static bool captureFirst = true;
+static uint32_t captureLast = 0;
+static uint32_t captureBuffer[captureBufferLength];
+static uint8_t captureHead = 0;
+static uint8_t captureTail = 0;
+
+//*********** LCD
+static char lcdBuffer[2][8];
+static uint8_t cursorCol = 0;
+static uint8_t cursorRow = 0;
+static unsigned long lcdWriteCount = 0;
+static unsigned long lcdClearCount = 0;
+static bool lcdDisplayOn = true;
+
+//*********** EEPROM
+static uint8_t eepromData[1024];
+static unsigned long eepromWriteCount[1024];
+
+//*********** Button, interrupts, serial, sleep
+static int pendingClicks = 0;
+static int pendingLongPresses = 0;
+static void (*interruptFunc[2])(void) = {0, 0};
+static std::string serialBuffer;
+static unsigned long sleepCount = 0;
+
+//*********** 1 PPS
+static bool ppsEnabled = false;
+static double ppsJitter = 0.0;                               // us
+static double ppsSecond = 0.0;                               // Next true second
+static double ppsNext = 0.0;                                 // MCU time of the next pulse
+static void (*ppsHandler)(unsigned long) = 0;
+
+//*********** I2C
+static int i2cAddress = -1;                                  // Slave address of the board, -1 when not on the bus
+static uint8_t i2cRxBuffer[BUFFER_LENGTH];
+static uint8_t i2cRxLength = 0;
+static uint8_t i2cRxIndex = 0;
+static uint8_t i2cTxBuffer[BUFFER_LENGTH];
+static uint8_t i2cTxLength = 0;
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+FreqCountClass FreqCount;
+FreqMeasureClass FreqMeasure;
+TwoWire Wire;
+
+//*********************************************************************************************************
+// Frequency seen at the end of a path, in edges per second of the MCU clock
+static double pathRate(simPath path) {
+
+  double rate = signalFrequency * (1.0 + pathError[path] * 1e-6) / (1.0 + crystalError * 1e-6);
+
+  if (path == sim_path_VHF1) rate /= 4;
+  if (path == sim_path_VHF2) rate /= 32;
+
+  return rate;
+}
+
+static double counterRate() {
+  double rate = pathRate(Pandauino_Freq_LF_VHF_sim::counterPath());
+  if (rate > counterMaxFrequency) rate = fmod(rate, counterMaxFrequency);
+  return rate;
+}
+
+static double captureRate() {
+  double rate = pathRate(sim_path_LF);
+  if (rate > captureMaxFrequency) rate = 0.0;
+  return rate;
+}
+
+//*********************************************************************************************************
+// MCU time of the pulse of the true second ppsSecond
+static void schedulePPS() {
+  ppsNext = ppsSecond * (1.0 + crystalError * 1e-6) + ppsJitter * 1e-6 * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+static void pulsePPS() {
+  if (ppsHandler) ppsHandler(micros() & ~3UL);
+  ppsSecond += 1.0;
+  schedulePPS();
+}
+
+//*********************************************************************************************************
+static void latchGate() {
+  countOutput = (uint32_t)(floor(t1Edges) - floor(gateStartEdges));
+  countReady = true;
+  gateStartEdges = t1Edges;
+  gateEnd += gatePeriod;
+}
+
+static void capture() {
+
+  uint32_t ticks = (uint32_t)(uint64_t)floor(simTime * F_CPU);
+
+  if (!captureFirst) {
+    uint8_t next = (captureHead + 1) % captureBufferLength;
+    if (next != captureTail) {            // when the buffer is full the capture is lost
+      captureBuffer[captureHead] = ticks - captureLast;
+      captureHead = next;
+    }
+  }
+
+  captureFirst = false;
+  captureLast = ticks;
+  nextCaptureEdge += capturePeriods;
+}
+
+/* ************************************************************************************************************************************
+  SIMULATION CONTROL
+**************************************************************************************************************************************/
+
+void Pandauino_Freq_LF_VHF_sim::reset() {
+
+  simTime = 0.0;
+  signalFrequency = 0.0;
+  for (int i = 0; i < 4; i++) pathError[i] = 0.0;
+  crystalError = 0.0;
+  vcc = 9.0;
+  memset(pins, LOW, sizeof(pins));
+
+  t1Edges = 0.5;
+  countRunning = false;
+  countReady = false;
+
+  icpEdges = 0.5;
+  captureRunning = false;
+  captureHead = captureTail = 0;
+
+  memset(lcdBuffer, ' ', sizeof(lcdBuffer));
+  cursorCol = cursorRow = 0;
+  lcdWriteCount = lcdClearCount = 0;
+  lcdDisplayOn = true;
+
+  memset(eepromData, 0xFF, sizeof(eepromData));
+  memset(eepromWriteCount, 0, sizeof(eepromWriteCount));
+
+  pendingClicks = pendingLongPresses = 0;
+  interruptFunc[0] = interruptFunc[1] = 0;
+  serialBuffer.clear();
+  sleepCount = 0;
+  i2cAddress = -1;
+  ppsEnabled = false;
+  ppsHandler = 0;
+}
+
+//*********************************************************************************************************
+// Moves the virtual clock, processing the gate ends and the captures in order
+void Pandauino_Freq_LF_VHF_sim::advance(unsigned long microseconds) {
+
+  double target = simTime + microseconds * 1e-6;
+
+  while (true) {
+
+    double next = target;
+    bool gateEvent = false;
+    bool captureEvent = false;
+    bool ppsEvent = false;
+    double t1 = counterRate();
+    double icp = captureRate();
+
+    if (countRunning && (gateEnd <= next)) {
+      next = gateEnd;
+      gateEvent = true;
+    }
+
+    if (captureRunning && (icp > 0.0)) {
+      double captureTime = simTime + (nextCaptureEdge - icpEdges) / icp;
+      if (captureTime < next) {
+        next = captureTime;
+        gateEvent = false;
+        captureEvent = true;
+      }
+    }
+
+    if (ppsEnabled && (ppsNext < next)) {
+      next = ppsNext;
+      gateEvent = false;
+      captureEvent = false;
+      ppsEvent = true;
+    }
+
+    t1Edges += t1 * (next - simTime);
+    if (captureEvent) icpEdges = nextCaptureEdge;
+    else icpEdges += icp * (next - simTime);
+    simTime = next;
+
+    if (gateEvent) latchGate();
+    if (captureEvent) capture();
+    if (ppsEvent) pulsePPS();
+
+    if (!gateEvent && !captureEvent && !ppsEvent) break;
+  }
+}
+
+double Pandauino_Freq_LF_VHF_sim::now() { return simTime; }
+
+void Pandauino_Freq_LF_VHF_sim::setSignal(double frequency) { signalFrequency = frequency; }
+double Pandauino_Freq_LF_VHF_sim::getSignal() { return signalFrequency; }
+void Pandauino_Freq_LF_VHF_sim::setPathError(simPath path, double ppm) { pathError[path] = ppm; }
+void Pandauino_Freq_LF_VHF_sim::setCrystalError(double ppm) { crystalError = ppm; }
+
+void Pandauino_Freq_LF_VHF_sim::setPPS(bool enabled, double jitter) {
+  ppsJitter = jitter;
+  if (enabled && !ppsEnabled) {
+    ppsSecond = floor(simTime / (1.0 + crystalError * 1e-6)) + 1.0;
+    schedulePPS();
+  }
+  ppsEnabled = enabled;
+}
+
+void Pandauino_Freq_LF_VHF_sim::setVcc(float volts) { vcc = volts; }
+
+void Pandauino_Freq_LF_VHF_sim::click() { pendingClicks++; }
+void Pandauino_Freq_LF_VHF_sim::longPress() { pendingLongPresses++; }
+
+const char *Pandauino_Freq_LF_VHF_sim::lcdText() {
+  static char text[17];
+  memcpy(text, lcdBuffer[0], 8);
+  memcpy(text + 8, lcdBuffer[1], 8);
+  text[16] = 0;
+  return text;
+}
+
+unsigned long Pandauino_Freq_LF_VHF_sim::lcdWrites() { return lcdWriteCount; }
+unsigned long Pandauino_Freq_LF_VHF_sim::lcdClears() { return lcdClearCount; }
+bool Pandauino_Freq_LF_VHF_sim::lcdOn() { return lcdDisplayOn; }
+
+uint8_t *Pandauino_Freq_LF_VHF_sim::eeprom() { return eepromData; }
+unsigned long Pandauino_Freq_LF_VHF_sim::eepromWrites(int address) { return eepromWriteCount[address]; }
+
+const std::string &Pandauino_Freq_LF_VHF_sim::serialOutput() { return serialBuffer; }
+void Pandauino_Freq_LF_VHF_sim::clearSerialOutput() { serialBuffer.clear(); }
+
+unsigned long Pandauino_Freq_LF_VHF_sim::sleeps() { return sleepCount; }
+
+// As the AVR Wire library: the receive handler gets the whole write, the request handler fills at most BUFFER_LENGTH bytes
+void Pandauino_Freq_LF_VHF_sim::i2cWrite(uint8_t address, const uint8_t *buffer, size_t size) {
+
+  if ((address != i2cAddress) || (size == 0)) return;
+  if (size > BUFFER_LENGTH) size = BUFFER_LENGTH;
+
+  memcpy(i2cRxBuffer, buffer, size);
+  i2cRxLength = size;
+  i2cRxIndex = 0;
+  if (Wire.receiveFunc) Wire.receiveFunc(size);
+}
+
+size_t Pandauino_Freq_LF_VHF_sim::i2cRead(uint8_t address, uint8_t *buffer, size_t size) {
+
+  if (address != i2cAddress) return 0;
+
+  i2cTxLength = 0;
+  if (Wire.requestFunc) Wire.requestFunc();
+  if (size > i2cTxLength) size = i2cTxLength;
+  memcpy(buffer, i2cTxBuffer, size);
+  return size;
+}
+
+// select1 select 2 effect
+// LOW	LOW		PSC = 32
+// LOW	HIGH	PSC = 4
+// HIGH	x			PSC = 1
+simPath Pandauino_Freq_LF_VHF_sim::counterPath() {
+  if (pins[select1Pin] == HIGH) return sim_path_HF;
+  if (pins[select2Pin] == HIGH) return sim_path_VHF1;
+  return sim_path_VHF2;
+}
+
+void Pandauino_Freq_LF_VHF_sim::serialWrite(const uint8_t *buffer, size_t size) {
+  serialBuffer.append((const char *)buffer, size);
+}
+
+void Pandauino_Freq_LF_VHF_sim::lcdWrite(uint8_t col, uint8_t row, uint8_t c) {
+  if ((col < 8) && (row < 2)) lcdBuffer[row][col] = c;
+  lcdWriteCount++;
+}
+
+/* ************************************************************************************************************************************
+  ARDUINO CORE
+**************************************************************************************************************************************/
+
+// 32 bits, they roll over as on the board
+unsigned long millis() { return (uint32_t)(uint64_t)(simTime * 1000.0); }
+unsigned long micros() { return (uint32_t)(uint64_t)(simTime * 1000000.0); }
+void delay(unsigned long ms) { Pandauino_Freq_LF_VHF_sim::advance(ms * 1000); }
+void delayMicroseconds(unsigned int us) { Pandauino_Freq_LF_VHF_sim::advance(us); }
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < nbPins) pins[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+  return (pin < nbPins) ? pins[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode) {
+  if (interruptNum < 2) interruptFunc[interruptNum] = userFunc;
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+  if (interruptNum < 2) interruptFunc[interruptNum] = 0;
+}
+
+//*********************************************************************************************************
+// Serial
+size_t HardwareSerial::write(uint8_t c) {
+  Pandauino_Freq_LF_VHF_sim::serialWrite(&c, 1);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  Pandauino_Freq_LF_VHF_sim::serialWrite(buffer, size);
+  return size;
+}
+
+size_t HardwareSerial::print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+
+size_t HardwareSerial::print(long n, int base) {
+  char buf[24];
+  if (base == 16) snprintf(buf, sizeof(buf), "%lX", n);
+  else snprintf(buf, sizeof(buf), "%ld", n);
+  return print(buf);
+}
+
+size_t HardwareSerial::print(unsigned long n, int base) {
+  char buf[24];
+  if (base == 16) snprintf(buf, sizeof(buf), "%lX", n);
+  else snprintf(buf, sizeof(buf), "%lu", n);
+  return print(buf);
+}
+
+size_t HardwareSerial::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return print(buf);
+}
+
+size_t HardwareSerial::println() { return print("\r\n"); }
+
+/* ************************************************************************************************************************************
+  LIBRARIES
+**************************************************************************************************************************************/
+
+//*********************************************************************************************************
+// EEPROM
+uint8_t EEPROMClass::read(int idx) {
+  return eepromData[idx & 0x3FF];
+}
+
+void EEPROMClass::write(int idx, uint8_t val) {
+  eepromData[idx & 0x3FF] = val;
+  eepromWriteCount[idx & 0x3FF]++;
+}
+
+void EEPROMClass::update(int idx, uint8_t val) {
+  if (read(idx) != val) write(idx, val);
+}
+
+//*********************************************************************************************************
+// FreqCount
+void FreqCountClass::begin(uint16_t msec) {
+  gatePeriod = ((msec > 0) ? msec : 1) * 1e-3;
+  gateEnd = simTime + gatePeriod;
+  gateStartEdges = t1Edges;
+  countReady = false;
+  countRunning = true;
+}
+
+uint8_t FreqCountClass::available() { return countReady; }
+
+uint32_t FreqCountClass::read() {
+  countReady = false;
+  return countOutput;
+}
+
+void FreqCountClass::end() { countRunning = false; }
+
+//*********************************************************************************************************
+// FreqMeasure
+void FreqMeasureClass::begin(float periods) {
+  capturePeriods = (periods < 1.0) ? 1 : (uint32_t)periods;
+  nextCaptureEdge = floor(icpEdges) + 1.0;
+  captureFirst = true;
+  captureHead = captureTail = 0;
+  captureRunning = true;
+}
+
+uint8_t FreqMeasureClass::available() {
+  return (captureHead + captureBufferLength - captureTail) % captureBufferLength;
+}
+
+uint32_t FreqMeasureClass::read() {
+  if (captureHead == captureTail) return 0xFFFFFFFF;
+  uint32_t count = captureBuffer[captureTail];
+  captureTail = (captureTail + 1) % captureBufferLength;
+  return count;
+}
+
+void FreqMeasureClass::end() { captureRunning = false; }
+
+//*********************************************************************************************************
+// LiquidCrystal
+void LiquidCrystal::begin(uint8_t cols, uint8_t rows) { clear(); }
+
+void LiquidCrystal::clear() {
+  memset(lcdBuffer, ' ', sizeof(lcdBuffer));
+  cursorCol = cursorRow = 0;
+  lcdClearCount++;
+}
+
+void LiquidCrystal::setCursor(uint8_t col, uint8_t row) {
+  cursorCol = col;
+  cursorRow = row;
+}
+
+size_t LiquidCrystal::write(uint8_t c) {
+  Pandauino_Freq_LF_VHF_sim::lcdWrite(cursorCol++, cursorRow, c);
+  return 1;
+}
+
+size_t LiquidCrystal::print(const char *s) {
+  size_t n = 0;
+  while (*s) n += write(*s++);
+  return n;
+}
+
+void LiquidCrystal::display() { lcdDisplayOn = true; }
+void LiquidCrystal::noDisplay() { lcdDisplayOn = false; }
+
+//*********************************************************************************************************
+// Wire
+void TwoWire::begin(uint8_t address) { i2cAddress = address; }
+void TwoWire::end() { i2cAddress = -1; }
+
+int TwoWire::available() { return i2cRxLength - i2cRxIndex; }
+
+int TwoWire::read() {
+  if (i2cRxIndex >= i2cRxLength) return -1;
+  return i2cRxBuffer[i2cRxIndex++];
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (i2cTxLength >= BUFFER_LENGTH) return 0;
+  i2cTxBuffer[i2cTxLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  size_t n = 0;
+  while ((n < quantity) && write(data[n])) n++;
+  return n;
+}
+
+//*********************************************************************************************************
+// OneButton: one event per tick
+void OneButton::tick() {
+
+  if (pendingLongPresses > 0) {
+    pendingLongPresses--;
+    if (longPressStartFunc) longPressStartFunc();
+  } else if (pendingClicks > 0) {
+    pendingClicks--;
+    if (clickFunc) clickFunc();
+  }
+}
+
+/* ************************************************************************************************************************************
+  HAL FUNCTIONS
+**************************************************************************************************************************************/
+
+void halInitAdc() {}
+
+void halAdcPower(bool on) {}
+
+unsigned int halReadAdc() {
+  double adc = vcc * vccDivider * 1024 / vref;
+  if (adc > 1023) adc = 1023;
+  return (unsigned int)adc;
+}
+
+// The board sleeps until the menu button wakes it up
+void halPowerDown() {
+  sleepCount++;
+  if (interruptFunc[0]) interruptFunc[0]();
+}
+
+void halBeginPPS(byte pin, void (*handler)(unsigned long)) {
+  if ((pin < 11) || (pin > 13)) return;
+  ppsHandler = handler;
+}
+
+void halEndPPS() { ppsHandler = 0; }
+
+//*********************************************************************************************************
+// The simulated board starts in its power up state
+static struct simPowerUp {
+  simPowerUp() { Pandauino_Freq_LF_VHF_sim::reset(); }
+} simPowerUpInstance;
+
+#endif // ARDUINO
@@ -0,0 +1,312 @@
+/*  Pandauino_Freq_LF_VHF frequency counter library
+ *  Simulated backend of the hardware abstraction layer
+ *
+ *  Used when the library is compiled outside of the Arduino environment (ARDUINO not defined).
+ *  It provides the subset of the Arduino core, FreqCount, FreqMeasure, LiquidCrystal, EEPROM, OneButton and Wire
+ *  used by the library, on top of a simulated "Freq_LF_VHF v1.0" board:
+ *
+ *  ** a virtual clock. millis(), micros() and delay() use it. It only moves with delay() and Pandauino_Freq_LF_VHF_sim::advance()
+ *     millis() and micros() roll over at 32 bits as on the board. Build with -m32 for a 32 bits long as avr-gcc:
+ *     with a 64 bits long the differences of time stamps across a roll over and the overflows of long are not those of the board
+ *
+ *  ** a synthetic input signal seen through the four measurement paths: LF input capture, HF direct, VHF1 (/4) and VHF2 (/32)
+ *     with a systematic error per path and a crystal (timebase) error
+ *
+ *  ** an 8x2 LCD framebuffer displayed as 16 characters on one line
+ *
+ *  ** a RAM backed 1 KB EEPROM with a write counter per cell
+ *
+ *  ** the menu push button, the power voltage and the serial port
+ *
+ *  ** an I2C master talking to the board in slave mode
+ *
+ *  ** a 1 PPS source, as a GPS receiver, with a timing jitter. beginDiscipline() needs the library built with -DFREQ_PPS_ON_PCINT0
+ *
+ *  Example, compiled on the host with
+ *  g++ -std=c++11 -m32 -Isrc main.cpp src/Pandauino_Freq_LF_VHF.cpp src/sim/Pandauino_Freq_LF_VHF_sim.cpp
+ *
+ *    #include <Pandauino_Freq_LF_VHF.h>
+ *
+ *    int main() {
+ *      Pandauino_Freq_LF_VHF_sim::setSignal(14318180.0);
+ *      frequencyCounter.freqSetup(board_version_vhf);
+ *      for (long i = 0; i < 100000; i++) {       // 100 simulated seconds
+ *        frequencyCounter.freqCount();
+ *        Pandauino_Freq_LF_VHF_sim::advance(1000);
+ *      }
+ *      printf("%s\n", Pandauino_Freq_LF_VHF_sim::lcdText());
+ *    }
+ *
+ *  Licence CC BY-NC-SA 4.0 see https://creativecommons.org/licenses/by-nc-sa/4.0/
+ *  You are free to use, modifiy and distribute this software for non commercial use while keeping the original attribution to Pandauino.com
+ */
+
+#ifndef Pandauino_Freq_LF_VHF_sim_h
+#define Pandauino_Freq_LF_VHF_sim_h
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+using std::abs;
+
+/* ************************************************************************************************************************************
+  ARDUINO CORE
+**************************************************************************************************************************************/
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+#define noInterrupts()
+#define interrupts()
+
+// Program memory: one address space on the host
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define strcpy_P(destination, source) strcpy((destination), (source))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void delayMicroseconds(unsigned int);
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+
+void attachInterrupt(uint8_t, void (*)(void), int mode);
+void detachInterrupt(uint8_t);
+
+//*********************************************************************************************************
+// Serial port: everything written goes to Pandauino_Freq_LF_VHF_sim::serialOutput()
+class HardwareSerial {
+  public:
+    void begin(long) {}
+    void end() {}
+    operator bool() { return true; }
+    int availableForWrite() { return 63; }
+    size_t write(uint8_t);
+    size_t write(const uint8_t *, size_t);
+    size_t print(const char *);
+    size_t print(char);
+    size_t print(long, int base = 10);
+    size_t print(int n, int base = 10) { return print((long)n, base); }
+    size_t print(unsigned long, int base = 10);
+    size_t print(double, int digits = 2);
+    size_t println();
+    size_t println(const char *s) { return print(s) + println(); }
+    size_t println(long n, int base = 10) { return print(n, base) + println(); }
+    size_t println(int n, int base = 10) { return print(n, base) + println(); }
+    size_t println(unsigned long n, int base = 10) { return print(n, base) + println(); }
+    size_t println(double n, int digits = 2) { return print(n, digits) + println(); }
+};
+
+extern HardwareSerial Serial;
+
+/* ************************************************************************************************************************************
+  LIBRARIES
+**************************************************************************************************************************************/
+
+//*********************************************************************************************************
+// EEPROM
+class EEPROMClass {
+  public:
+    uint8_t read(int);
+    void write(int, uint8_t);
+    void update(int, uint8_t);
+    uint16_t length() { return 1024; }
+    template <class T> T &get(int idx, T &t) {
+      uint8_t *ptr = (uint8_t *) &t;
+      for (size_t i = 0; i < sizeof(T); i++) *ptr++ = read(idx++);
+      return t;
+    }
+    template <class T> const T &put(int idx, const T &t) {
+      const uint8_t *ptr = (const uint8_t *) &t;
+      for (size_t i = 0; i < sizeof(T); i++) update(idx++, *ptr++);
+      return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+//*********************************************************************************************************
+// FreqCount: gated counting of the T1 input, which is the HF / VHF1 / VHF2 path selected by the select pins
+class FreqCountClass {
+  public:
+    void begin(uint16_t msec);
+    uint8_t available();
+    uint32_t read();
+    void end();
+};
+
+extern FreqCountClass FreqCount;
+
+//*********************************************************************************************************
+// FreqMeasure: input capture of the LF path, one capture every "periods" periods (Mrguen fork)
+class FreqMeasureClass {
+  public:
+    void begin(float periods);
+    uint8_t available();
+    uint32_t read();
+    float countToFrequency(uint32_t count) { return (float)F_CPU / (float)count; }
+    void end();
+};
+
+extern FreqMeasureClass FreqMeasure;
+
+//*********************************************************************************************************
+// LiquidCrystal: 4 bit interface, only the framebuffer is simulated
+class LiquidCrystal {
+  public:
+    LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3) {}
+    void begin(uint8_t cols, uint8_t rows);
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t write(uint8_t);
+    size_t print(const char *);
+    void display();
+    void noDisplay();
+};
+
+//*********************************************************************************************************
+// OneButton: the events are injected by Pandauino_Freq_LF_VHF_sim::click() and longPress()
+class OneButton {
+  public:
+    OneButton(int pin, bool activeLow = true) {}
+    void tick();
+    void setClickTicks(int) {}
+    void attachClick(void (*newFunction)(void)) { clickFunc = newFunction; }
+    void attachLongPressStart(void (*newFunction)(void)) { longPressStartFunc = newFunction; }
+    void attachDoubleClick(void (*newFunction)(void)) { doubleClickFunc = newFunction; }
+  private:
+    void (*clickFunc)(void) = 0;
+    void (*longPressStartFunc)(void) = 0;
+    void (*doubleClickFunc)(void) = 0;
+};
+
+//*********************************************************************************************************
+// Wire: slave mode only. The master transactions are injected by Pandauino_Freq_LF_VHF_sim::i2cWrite() and i2cRead()
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+  public:
+    void begin(uint8_t address);
+    void end();
+    void onReceive(void (*function)(int)) { receiveFunc = function; }
+    void onRequest(void (*function)(void)) { requestFunc = function; }
+    int available();
+    int read();
+    size_t write(uint8_t);
+    size_t write(const uint8_t *, size_t);
+  private:
+    friend class Pandauino_Freq_LF_VHF_sim;
+    void (*receiveFunc)(int) = 0;
+    void (*requestFunc)(void) = 0;
+};
+
+extern TwoWire Wire;
+
+/* ************************************************************************************************************************************
+  HAL FUNCTIONS
+**************************************************************************************************************************************/
+
+void halInitAdc();
+void halAdcPower(bool);
+unsigned int halReadAdc();
+void halPowerDown();
+void halBeginPPS(byte pin, void (*handler)(unsigned long));
+void halEndPPS();
+
+/* ************************************************************************************************************************************
+  SIMULATION CONTROL
+**************************************************************************************************************************************/
+
+enum simPath {
+  sim_path_LF,          // LF input capture (FreqMeasure)
+  sim_path_HF,          // HF direct path to the T1 counter input
+  sim_path_VHF1,        // /4 prescaler path to the T1 counter input
+  sim_path_VHF2         // /32 prescaler path to the T1 counter input
+};
+
+class Pandauino_Freq_LF_VHF_sim {
+
+  public:
+
+    // Puts the board back to its power up state: time 0, no signal, blank EEPROM
+    static void reset();
+
+    // Moves the virtual clock. Counter gates and input captures falling in this time are processed.
+    static void advance(unsigned long microseconds);
+    static double now();                                  // Virtual time in seconds
+
+    // Input signal, 0.0 for no signal
+    static void setSignal(double frequency);
+    static double getSignal();
+    static void setPathError(simPath path, double ppm);   // Systematic error of a measurement path
+    static void setCrystalError(double ppm);              // Error of the 16 MHz timebase
+
+    // 1 PPS input: one pulse per true second, i.e. 1 + crystal error seconds of the MCU clock,
+    // moved by a uniform random jitter of +/- jitter us. The timestamps have the 4 us resolution of micros() on AVR
+    static void setPPS(bool enabled, double jitter = 0.0);
+
+    // Board power voltage
+    static void setVcc(float volts);
+
+    // Menu button events, delivered at the next OneButton::tick()
+    static void click();
+    static void longPress();
+
+    // LCD framebuffer: the 16 characters seen on the 8x2 LCD, and the number of characters written / clears
+    static const char *lcdText();
+    static unsigned long lcdWrites();
+    static unsigned long lcdClears();
+    static bool lcdOn();
+
+    // EEPROM content and number of writes of a cell
+    static uint8_t *eeprom();
+    static unsigned long eepromWrites(int address);
+
+    // Serial output
+    static const std::string &serialOutput();
+    static void clearSerialOutput();
+
+    // Number of times the board went to power down
+    static unsigned long sleeps();
+
+    // I2C master: a write transaction to the board, and a read transaction returning the number of bytes received
+    // Both do nothing when the board did not join the bus with Wire.begin(address)
+    static void i2cWrite(uint8_t address, const uint8_t *, size_t);
+    static size_t i2cRead(uint8_t address, uint8_t *, size_t);
+
+    // Used by the simulated libraries
+    static simPath counterPath();
+    static void serialWrite(const uint8_t *, size_t);
+    static void lcdWrite(uint8_t col, uint8_t row, uint8_t c);
+};
+
+#endif // ARDUINO
+
+#endif